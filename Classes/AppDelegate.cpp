@@ -5,6 +5,7 @@
 #include "Scenes/MainScene.h"
 #include "Scenes/LoginScene.h"
 #include "Managers/SoundManager.h"
+#include "Data/SaveWorker.h"
 #include"Scenes/MenuScene.h"
 #include <vector>
 #include <string>
@@ -67,7 +68,9 @@ static void AddFallbackResourceSearchPaths() {
 
 AppDelegate::AppDelegate() {}
 
-AppDelegate::~AppDelegate() {}
+AppDelegate::~AppDelegate() {
+    SaveWorker::shutdown();
+}
 
 void AppDelegate::initGLContextAttrs() {
     GLContextAttrs attrs = {8, 8, 8, 8, 24, 8};
@@ -101,6 +104,8 @@ bool AppDelegate::applicationDidFinishLaunching() {
 void AppDelegate::applicationDidEnterBackground() {
     Director::getInstance()->stopAnimation();
     SoundManager::pause();
+    // The OS may kill a backgrounded app; make sure queued saves reach the disk.
+    SaveWorker::flush();
 }
 
 void AppDelegate::applicationWillEnterForeground() {
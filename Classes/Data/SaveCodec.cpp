@@ -0,0 +1,1198 @@
+// File: SaveCodec.cpp
+// Brief: Implements the SaveCodec component.
+#include "Data/SaveCodec.h"
+#include "cocos2d.h"
+#include "json/memorystream.h"
+#include "json/reader.h"
+#include "json/writer.h"
+#include "zlib.h"
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstring>
+
+#if defined(__SSE4_2__) || defined(__AVX__)
+#include <nmmintrin.h>
+#define COC_SAVE_CRC_SSE42 1
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define COC_SAVE_CRC_ARM 1
+#endif
+
+USING_NS_CC;
+
+namespace {
+
+// Little-endian stores/loads. Byte-wise so they work on any host and alignment.
+inline void put16(uint8_t* p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+inline void put32(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+inline void put64(uint8_t* p, uint64_t v)
+{
+    put32(p, (uint32_t)v);
+    put32(p + 4, (uint32_t)(v >> 32));
+}
+
+inline void putF32(uint8_t* p, float v)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    put32(p, bits);
+}
+
+inline uint16_t get16(const uint8_t* p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+inline uint32_t get32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+inline uint64_t get64(const uint8_t* p)
+{
+    return (uint64_t)get32(p) | ((uint64_t)get32(p + 4) << 32);
+}
+
+inline float getF32(const uint8_t* p)
+{
+    const uint32_t bits = get32(p);
+    float v;
+    std::memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+// Header field offsets (version 1).
+enum HeaderOffset {
+    H_MAGIC = 0,
+    H_VERSION = 4,
+    H_FLAGS = 6,
+    H_HEADER_SIZE = 8,
+    H_BUILDING_SIZE = 10,
+    H_TROOP_SIZE = 12,
+    H_LEVEL_SIZE = 14,
+    H_BUILDING_COUNT = 16,
+    H_TROOP_COUNT = 20,
+    H_LEVEL_COUNT = 24,
+    H_STRING_SIZE = 28,
+    H_UPDATED_AT = 32,
+    H_LAST_REAL_TIME = 40,
+    H_GOLD = 48,
+    H_ELIXIR = 52,
+    H_POPULATION = 56,
+    H_TIME_SCALE = 60,
+    H_RESEARCH_UNIT = 64,
+    H_RESEARCH_TARGET = 68,
+    H_RESEARCH_TOTAL = 72,
+    H_RESEARCH_REMAIN = 76,
+    H_NAME_OFFSET = 80,
+    H_NAME_LENGTH = 84,
+    H_GENERATION = 88,
+};
+
+// Header fields before the generation was added.
+const uint32_t kHeaderSizeV1 = 88;
+
+// Journal record types.
+enum JournalRecord {
+    J_SCALARS = 1,          // resources, research, lastRealTime
+    J_BUILDING_COUNT = 2,   // new number of buildings
+    J_BUILDING = 3,         // index + one building record
+    J_TROOPS = 4,           // every trained troop
+    J_LEVELS = 5,           // troop levels 1..4
+    J_NAME = 6,             // slot name
+};
+
+const size_t kJournalRecordHeader = 8;   // type (u16), reserved (u16), payload length (u32)
+const size_t kJournalChecksumSize = 4;
+const size_t kScalarsPayload = 36;
+
+// FNV-1a; only guards against torn appends, not against tampering.
+uint32_t recordChecksum(const uint8_t* p, size_t n)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; ++i)
+    {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+void putBuilding(uint8_t* p, const SaveBuilding& b)
+{
+    put32(p + 0, (uint32_t)b.id);
+    put32(p + 4, (uint32_t)b.level);
+    put32(p + 8, (uint32_t)b.r);
+    put32(p + 12, (uint32_t)b.c);
+    put32(p + 16, (uint32_t)b.hp);
+    putF32(p + 20, b.stored);
+    put32(p + 24, (uint32_t)b.buildState);
+    putF32(p + 28, b.buildTotalSec);
+    putF32(p + 32, b.buildRemainSec);
+    put32(p + 36, (uint32_t)b.upgradeTargetLevel);
+}
+
+void getBuilding(const uint8_t* p, SaveBuilding& b)
+{
+    b.id = (int32_t)get32(p + 0);
+    b.level = (int32_t)get32(p + 4);
+    b.r = (int32_t)get32(p + 8);
+    b.c = (int32_t)get32(p + 12);
+    b.hp = (int32_t)get32(p + 16);
+    b.stored = getF32(p + 20);
+    b.buildState = (int32_t)get32(p + 24);
+    b.buildTotalSec = getF32(p + 28);
+    b.buildRemainSec = getF32(p + 32);
+    b.upgradeTargetLevel = (int32_t)get32(p + 36);
+}
+
+bool sameBuilding(const SaveBuilding& a, const SaveBuilding& b)
+{
+    return a.id == b.id && a.level == b.level && a.r == b.r && a.c == b.c && a.hp == b.hp
+        && a.stored == b.stored && a.buildState == b.buildState
+        && a.buildTotalSec == b.buildTotalSec && a.buildRemainSec == b.buildRemainSec
+        && a.upgradeTargetLevel == b.upgradeTargetLevel;
+}
+
+bool sameTroops(const std::vector<SaveTrainedTroop>& a, const std::vector<SaveTrainedTroop>& b)
+{
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        if (a[i].type != b[i].type || a[i].r != b[i].r || a[i].c != b[i].c) return false;
+    }
+    return true;
+}
+
+int troopLevelOf(const SaveData& d, int id)
+{
+    auto it = d.troopLevels.find(id);
+    return it != d.troopLevels.end() ? it->second : 1;
+}
+
+// Reserves a record of the given payload size at the end of out and returns a
+// pointer to the payload; finishRecord() fills in the checksum.
+uint8_t* beginRecord(std::vector<uint8_t>& out, JournalRecord type, size_t payload)
+{
+    const size_t at = out.size();
+    out.resize(at + kJournalRecordHeader + payload + kJournalChecksumSize, 0);
+    uint8_t* p = out.data() + at;
+    put16(p + 0, (uint16_t)type);
+    put16(p + 2, 0);
+    put32(p + 4, (uint32_t)payload);
+    return p + kJournalRecordHeader;
+}
+
+void finishRecord(std::vector<uint8_t>& out, size_t payload)
+{
+    uint8_t* end = out.data() + out.size();
+    uint8_t* rec = end - kJournalChecksumSize - payload - kJournalRecordHeader;
+    put32(end - kJournalChecksumSize, recordChecksum(rec, kJournalRecordHeader + payload));
+}
+
+std::string defaultName(int slot)
+{
+    return cocos2d::StringUtils::format("Save %02d", slot + 1);
+}
+
+#if !defined(COC_SAVE_CRC_SSE42) && !defined(COC_SAVE_CRC_ARM)
+// Slice-by-8 tables for the reflected Castagnoli polynomial.
+struct Crc32cTables {
+    uint32_t t[8][256];
+    Crc32cTables()
+    {
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c >> 1) ^ (0x82F63B78u & (0u - (c & 1u)));
+            t[0][i] = c;
+        }
+        for (uint32_t i = 0; i < 256; ++i)
+            for (int k = 1; k < 8; ++k) t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+    }
+};
+#endif
+
+// BodySource hands out the records that follow the header, n bytes at a time. For a
+// plain file it points into the file bytes; for a deflated one it inflates into a
+// small window as the decoder asks for more, so no full-size copy of the body is
+// made. take() returns nullptr once the body runs out or the stream is corrupt.
+class BodySource {
+public:
+    BodySource(const uint8_t* bytes, size_t size, bool deflated)
+        : _p(bytes), _end(bytes + size), _deflated(deflated)
+    {
+        if (!_deflated) return;
+        std::memset(&_zs, 0, sizeof(_zs));
+        _zs.next_in = const_cast<Bytef*>(bytes);
+        _zs.avail_in = (uInt)size;
+        _ok = inflateInit(&_zs) == Z_OK;
+        _window.resize(kWindow);
+    }
+    ~BodySource()
+    {
+        if (_deflated && _ok) inflateEnd(&_zs);
+    }
+
+    const uint8_t* take(size_t n)
+    {
+        if (!_deflated)
+        {
+            if ((size_t)(_end - _p) < n) return nullptr;
+            const uint8_t* r = _p;
+            _p += n;
+            return r;
+        }
+        if (!_ok) return nullptr;
+        if (_len - _pos < n && !refill(n)) return nullptr;
+        const uint8_t* r = _window.data() + _pos;
+        _pos += n;
+        return r;
+    }
+
+private:
+    static const size_t kWindow = 4096;
+
+    bool refill(size_t n)
+    {
+        // Keep the unread tail, then inflate behind it until n bytes are buffered.
+        const size_t keep = _len - _pos;
+        if (keep > 0) std::memmove(_window.data(), _window.data() + _pos, keep);
+        _pos = 0;
+        _len = keep;
+        if (_window.size() < n) _window.resize(n);
+        while (_len < n)
+        {
+            _zs.next_out = _window.data() + _len;
+            _zs.avail_out = (uInt)(_window.size() - _len);
+            const int rc = inflate(&_zs, Z_NO_FLUSH);
+            _len = _window.size() - _zs.avail_out;
+            if (rc == Z_STREAM_END) break;
+            if (rc != Z_OK) { _ok = false; return false; }
+        }
+        return _len >= n;
+    }
+
+    const uint8_t* _p;
+    const uint8_t* _end;
+    bool _deflated;
+    bool _ok = true;
+    z_stream _zs;
+    std::vector<uint8_t> _window;
+    size_t _pos = 0;
+    size_t _len = 0;
+};
+
+// rapidjson output stream appending to a byte vector, so encodeJson writes straight
+// into the caller's (reused) buffer.
+struct ByteStream {
+    typedef char Ch;
+    explicit ByteStream(std::vector<uint8_t>& out) : bytes(out) {}
+    void Put(Ch c) { bytes.push_back(static_cast<uint8_t>(c)); }
+    void Flush() {}
+    std::vector<uint8_t>& bytes;
+};
+
+// Scratch allocator for the JSON reader's string stack and the writer's nesting
+// stack. Backed by a static block that saves never outgrow, so steady-state
+// import/export does no heap allocation for it. Main thread only, like SaveSystem.
+struct JsonPool {
+    typedef rapidjson::MemoryPoolAllocator<> Allocator;
+    static Allocator& get()
+    {
+        // The allocator puts its chunk header at the start of the block.
+        alignas(std::max_align_t) static char block[16 * 1024];
+        static Allocator pool(block, sizeof(block));
+        return pool;
+    }
+};
+
+// SAX handler for the legacy JSON layout. Fills SaveData as the tokens arrive and
+// keeps the rules of the old DOM reader: fields with the wrong type keep their
+// default, a building needs id, level, r and c, unknown members are skipped.
+class JsonSaveHandler
+    : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, JsonSaveHandler> {
+public:
+    explicit JsonSaveHandler(SaveData& out) : _out(out) {}
+
+    bool sawRoot() const { return _sawRoot; }
+
+    bool Default() { return onScalar(Scalar()); }
+    bool Int(int i)
+    {
+        Scalar v;
+        v.isInt = v.isInt64 = v.isNumber = true;
+        v.i = i;
+        v.d = i;
+        return onScalar(v);
+    }
+    bool Uint(unsigned u)
+    {
+        Scalar v;
+        v.isInt = u <= (unsigned)INT_MAX;
+        v.isInt64 = v.isNumber = true;
+        v.i = u;
+        v.d = u;
+        return onScalar(v);
+    }
+    bool Int64(int64_t i)
+    {
+        Scalar v;
+        v.isInt64 = v.isNumber = true;
+        v.i = i;
+        v.d = (double)i;
+        return onScalar(v);
+    }
+    bool Uint64(uint64_t u)
+    {
+        Scalar v;
+        v.isInt64 = u <= (uint64_t)INT64_MAX;
+        v.isNumber = true;
+        v.i = (int64_t)u;
+        v.d = (double)u;
+        return onScalar(v);
+    }
+    bool Double(double d)
+    {
+        Scalar v;
+        v.isNumber = true;
+        v.d = d;
+        return onScalar(v);
+    }
+    bool String(const char* str, rapidjson::SizeType len, bool)
+    {
+        Scalar v;
+        v.str = str;
+        v.len = len;
+        return onScalar(v);
+    }
+
+    bool Key(const char* str, rapidjson::SizeType len, bool)
+    {
+        if (_skip == 0) _key.assign(str, len);
+        return true;
+    }
+
+    bool StartObject()
+    {
+        if (_skip > 0) { ++_skip; return true; }
+        switch (_ctx)
+        {
+        case C_NONE:
+            _sawRoot = true;
+            _ctx = C_ROOT;
+            return true;
+        case C_ROOT:
+            if (_key == "meta") _ctx = C_META;
+            else if (_key == "resources") _ctx = C_RESOURCES;
+            else if (_key == "research") _ctx = C_RESEARCH;
+            else _skip = 1;
+            return true;
+        case C_BUILDINGS:
+            _building = SaveBuilding();
+            _required = 0;
+            _ctx = C_BUILDING;
+            return true;
+        case C_TROOPS:
+            _troop = SaveTrainedTroop();
+            _ctx = C_TROOP;
+            return true;
+        case C_LEVELS:
+            _levelId = _levelValue = 0;
+            _levelHasId = _levelHasValue = false;
+            _ctx = C_LEVEL;
+            return true;
+        default:
+            _skip = 1;
+            return true;
+        }
+    }
+
+    bool EndObject(rapidjson::SizeType)
+    {
+        if (_skip > 0) { --_skip; return true; }
+        switch (_ctx)
+        {
+        case C_META:
+        case C_RESOURCES:
+        case C_RESEARCH:
+            _ctx = C_ROOT;
+            return true;
+        case C_BUILDING:
+            if (_required == R_ALL) _out.buildings.push_back(_building);
+            _ctx = C_BUILDINGS;
+            return true;
+        case C_TROOP:
+            if (_troop.type > 0) _out.trainedTroops.push_back(_troop);
+            _ctx = C_TROOPS;
+            return true;
+        case C_LEVEL:
+            if (_levelHasId && _levelHasValue && _levelId >= 1 && _levelId <= 4)
+                _out.troopLevels[_levelId] = std::max(1, _levelValue);
+            _ctx = C_LEVELS;
+            return true;
+        default:
+            _ctx = C_DONE;
+            return true;
+        }
+    }
+
+    bool StartArray()
+    {
+        if (_skip > 0) { ++_skip; return true; }
+        if (_ctx == C_NONE) return false;   // root must be an object
+        if (_ctx == C_ROOT)
+        {
+            if (_key == "buildings") { _ctx = C_BUILDINGS; return true; }
+            if (_key == "trainedTroops") { _ctx = C_TROOPS; return true; }
+            if (_key == "troopLevels") { _ctx = C_LEVELS; return true; }
+        }
+        _skip = 1;
+        return true;
+    }
+
+    bool EndArray(rapidjson::SizeType)
+    {
+        if (_skip > 0) { --_skip; return true; }
+        _ctx = C_ROOT;
+        return true;
+    }
+
+private:
+    enum Context {
+        C_NONE, C_ROOT, C_DONE,
+        C_META, C_RESOURCES, C_RESEARCH,
+        C_BUILDINGS, C_BUILDING, C_TROOPS, C_TROOP, C_LEVELS, C_LEVEL,
+    };
+    enum Required { R_ID = 1, R_LEVEL = 2, R_R = 4, R_C = 8, R_ALL = 15 };
+
+    // One scalar token, with the type tests the DOM reader used (IsInt, IsInt64,
+    // IsNumber, IsString).
+    struct Scalar {
+        bool isInt = false;
+        bool isInt64 = false;
+        bool isNumber = false;
+        int64_t i = 0;
+        double d = 0.0;
+        const char* str = nullptr;
+        size_t len = 0;
+    };
+
+    static void setInt(const Scalar& v, int& field) { if (v.isInt) field = (int)v.i; }
+    static void setFloat(const Scalar& v, float& field) { if (v.isNumber) field = (float)v.d; }
+
+    bool onScalar(const Scalar& v)
+    {
+        if (_skip > 0) return true;
+        const std::string& k = _key;
+        switch (_ctx)
+        {
+        case C_NONE:
+            return false;   // root must be an object
+        case C_META:
+            if (k == "name") { if (v.str) _out.name.assign(v.str, v.len); }
+            else if (k == "lastRealTime") { if (v.isInt64) _out.lastRealTime = v.i; }
+            break;
+        case C_RESOURCES:
+            if (k == "gold") setInt(v, _out.gold);
+            else if (k == "elixir") setInt(v, _out.elixir);
+            else if (k == "population") setInt(v, _out.population);
+            break;
+        case C_RESEARCH:
+            if (k == "unitId") setInt(v, _out.researchUnitId);
+            else if (k == "targetLevel") setInt(v, _out.researchTargetLevel);
+            else if (k == "totalSec") setFloat(v, _out.researchTotalSec);
+            else if (k == "remainSec") setFloat(v, _out.researchRemainSec);
+            break;
+        case C_BUILDING:
+            if (k == "id") { _required |= R_ID; setInt(v, _building.id); }
+            else if (k == "level") { _required |= R_LEVEL; setInt(v, _building.level); }
+            else if (k == "r") { _required |= R_R; setInt(v, _building.r); }
+            else if (k == "c") { _required |= R_C; setInt(v, _building.c); }
+            else if (k == "hp") setInt(v, _building.hp);
+            else if (k == "stored") setFloat(v, _building.stored);
+            else if (k == "buildState") setInt(v, _building.buildState);
+            else if (k == "buildTotalSec") setFloat(v, _building.buildTotalSec);
+            else if (k == "buildRemainSec") setFloat(v, _building.buildRemainSec);
+            else if (k == "upgradeTargetLevel") setInt(v, _building.upgradeTargetLevel);
+            break;
+        case C_TROOP:
+            if (k == "type") setInt(v, _troop.type);
+            else if (k == "r") setInt(v, _troop.r);
+            else if (k == "c") setInt(v, _troop.c);
+            break;
+        case C_LEVEL:
+            if (k == "id" && v.isInt) { _levelId = (int)v.i; _levelHasId = true; }
+            else if (k == "level" && v.isInt) { _levelValue = (int)v.i; _levelHasValue = true; }
+            break;
+        default:
+            break;   // root members we do not read, array elements that are not objects
+        }
+        return true;
+    }
+
+    SaveData& _out;
+    Context _ctx = C_NONE;
+    int _skip = 0;              // depth inside a member we ignore
+    bool _sawRoot = false;
+    std::string _key;           // reused; keys are short enough for the SSO buffer
+
+    SaveBuilding _building;
+    int _required = 0;
+    SaveTrainedTroop _troop;
+    int _levelId = 0;
+    int _levelValue = 0;
+    bool _levelHasId = false;
+    bool _levelHasValue = false;
+};
+
+}  // namespace
+
+uint32_t SaveCodec::crc32c(const uint8_t* p, size_t n)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+#if defined(COC_SAVE_CRC_SSE42) && (defined(__x86_64__) || defined(_M_X64))
+    uint64_t c64 = crc;
+    for (; n >= 8; p += 8, n -= 8)
+    {
+        uint64_t v;
+        std::memcpy(&v, p, 8);
+        c64 = _mm_crc32_u64(c64, v);
+    }
+    crc = (uint32_t)c64;
+    for (; n > 0; ++p, --n) crc = _mm_crc32_u8(crc, *p);
+#elif defined(COC_SAVE_CRC_SSE42)
+    for (; n >= 4; p += 4, n -= 4)
+    {
+        uint32_t v;
+        std::memcpy(&v, p, 4);
+        crc = _mm_crc32_u32(crc, v);
+    }
+    for (; n > 0; ++p, --n) crc = _mm_crc32_u8(crc, *p);
+#elif defined(COC_SAVE_CRC_ARM)
+    for (; n >= 8; p += 8, n -= 8)
+    {
+        uint64_t v;
+        std::memcpy(&v, p, 8);
+        crc = __crc32cd(crc, v);
+    }
+    for (; n > 0; ++p, --n) crc = __crc32cb(crc, *p);
+#else
+    static const Crc32cTables tables;
+    const auto& t = tables.t;
+    for (; n >= 8; p += 8, n -= 8)
+    {
+        const uint32_t lo = crc ^ get32(p);
+        const uint32_t hi = get32(p + 4);
+        crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24]
+            ^ t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+    }
+    for (; n > 0; ++p, --n) crc = (crc >> 8) ^ t[0][(crc ^ *p) & 0xFF];
+#endif
+    return ~crc;
+}
+
+bool SaveCodec::isBinary(const uint8_t* bytes, size_t size)
+{
+    return bytes && size >= 4 && get32(bytes) == BINARY_MAGIC;
+}
+
+void SaveCodec::encodeBinary(const SaveData& data, int64_t updatedAt, int64_t lastRealTime,
+    uint64_t generation, std::vector<uint8_t>& out)
+{
+    const uint32_t buildingCount = (uint32_t)data.buildings.size();
+    const uint32_t troopCount = (uint32_t)data.trainedTroops.size();
+    const uint32_t levelCount = 4;
+    const uint32_t nameLength = (uint32_t)data.name.size();
+
+    const size_t total = (size_t)BINARY_HEADER_SIZE
+        + (size_t)buildingCount * BINARY_BUILDING_SIZE
+        + (size_t)troopCount * BINARY_TROOP_SIZE
+        + (size_t)levelCount * BINARY_LEVEL_SIZE
+        + nameLength;
+    out.assign(total, 0);
+    uint8_t* h = out.data();
+
+    put32(h + H_MAGIC, BINARY_MAGIC);
+    put16(h + H_VERSION, BINARY_VERSION);
+    put16(h + H_FLAGS, 0);
+    put16(h + H_HEADER_SIZE, BINARY_HEADER_SIZE);
+    put16(h + H_BUILDING_SIZE, BINARY_BUILDING_SIZE);
+    put16(h + H_TROOP_SIZE, BINARY_TROOP_SIZE);
+    put16(h + H_LEVEL_SIZE, BINARY_LEVEL_SIZE);
+    put32(h + H_BUILDING_COUNT, buildingCount);
+    put32(h + H_TROOP_COUNT, troopCount);
+    put32(h + H_LEVEL_COUNT, levelCount);
+    put32(h + H_STRING_SIZE, nameLength);
+    put64(h + H_UPDATED_AT, (uint64_t)updatedAt);
+    put64(h + H_LAST_REAL_TIME, (uint64_t)lastRealTime);
+    put32(h + H_GOLD, (uint32_t)data.gold);
+    put32(h + H_ELIXIR, (uint32_t)data.elixir);
+    put32(h + H_POPULATION, (uint32_t)data.population);
+    putF32(h + H_TIME_SCALE, 1.0f);
+    put32(h + H_RESEARCH_UNIT, (uint32_t)data.researchUnitId);
+    put32(h + H_RESEARCH_TARGET, (uint32_t)data.researchTargetLevel);
+    putF32(h + H_RESEARCH_TOTAL, data.researchTotalSec);
+    putF32(h + H_RESEARCH_REMAIN, data.researchRemainSec);
+    put32(h + H_NAME_OFFSET, 0);
+    put32(h + H_NAME_LENGTH, nameLength);
+    put64(h + H_GENERATION, generation);
+
+    uint8_t* p = h + BINARY_HEADER_SIZE;
+    for (const auto& b : data.buildings)
+    {
+        putBuilding(p, b);
+        p += BINARY_BUILDING_SIZE;
+    }
+
+    for (const auto& t : data.trainedTroops)
+    {
+        put32(p + 0, (uint32_t)t.type);
+        put32(p + 4, (uint32_t)t.r);
+        put32(p + 8, (uint32_t)t.c);
+        p += BINARY_TROOP_SIZE;
+    }
+
+    for (int id = 1; id <= (int)levelCount; ++id)
+    {
+        auto it = data.troopLevels.find(id);
+        put32(p + 0, (uint32_t)id);
+        put32(p + 4, (uint32_t)(it != data.troopLevels.end() ? it->second : 1));
+        p += BINARY_LEVEL_SIZE;
+    }
+
+    if (nameLength > 0) std::memcpy(p, data.name.data(), nameLength);
+
+    // Large villages: deflate the body in place of the plain records when it pays.
+    // Best-speed level; save files are rewritten often and read back at start-up.
+    uint16_t flags = BINARY_FLAG_CHECKSUM;
+    const size_t bodySize = total - BINARY_HEADER_SIZE;
+    if (bodySize >= BINARY_COMPRESS_MIN_BODY)
+    {
+        static thread_local std::vector<uint8_t> packed;
+        uLongf packedSize = compressBound((uLong)bodySize);
+        packed.resize(packedSize);
+        if (compress2(packed.data(), &packedSize, out.data() + BINARY_HEADER_SIZE, (uLong)bodySize,
+                Z_BEST_SPEED) == Z_OK && packedSize < bodySize)
+        {
+            std::memcpy(out.data() + BINARY_HEADER_SIZE, packed.data(), packedSize);
+            out.resize(BINARY_HEADER_SIZE + packedSize);
+            flags |= BINARY_FLAG_DEFLATE;
+        }
+    }
+    put16(out.data() + H_FLAGS, flags);
+
+    const size_t stored = out.size();
+    out.resize(stored + BINARY_CHECKSUM_SIZE);
+    put32(out.data() + stored, crc32c(out.data(), stored));
+}
+
+bool SaveCodec::decodeBinary(const uint8_t* bytes, size_t size, int slot, SaveData& out,
+    uint64_t* generation, int64_t* updatedAt)
+{
+    if (!isBinary(bytes, size) || size < kHeaderSizeV1) return false;
+    const uint8_t* h = bytes;
+
+    // Same major layout only; newer files may carry larger header/records.
+    if (get16(h + H_VERSION) != BINARY_VERSION) return false;
+    const uint16_t flags = get16(h + H_FLAGS);
+    if (flags & ~BINARY_KNOWN_FLAGS) return false;
+    const bool deflated = (flags & BINARY_FLAG_DEFLATE) != 0;
+    if (flags & BINARY_FLAG_CHECKSUM)
+    {
+        if (size < kHeaderSizeV1 + BINARY_CHECKSUM_SIZE) return false;
+        size -= BINARY_CHECKSUM_SIZE;
+        if (crc32c(bytes, size) != get32(bytes + size)) return false;
+    }
+    const uint32_t headerSize = get16(h + H_HEADER_SIZE);
+    const uint32_t buildingSize = get16(h + H_BUILDING_SIZE);
+    const uint32_t troopSize = get16(h + H_TROOP_SIZE);
+    const uint32_t levelSize = get16(h + H_LEVEL_SIZE);
+    if (headerSize < kHeaderSizeV1 || buildingSize < BINARY_BUILDING_SIZE
+        || troopSize < BINARY_TROOP_SIZE || levelSize < BINARY_LEVEL_SIZE) return false;
+
+    const uint32_t buildingCount = get32(h + H_BUILDING_COUNT);
+    const uint32_t troopCount = get32(h + H_TROOP_COUNT);
+    const uint32_t levelCount = get32(h + H_LEVEL_COUNT);
+    const uint32_t stringSize = get32(h + H_STRING_SIZE);
+
+    const uint64_t need = (uint64_t)headerSize
+        + (uint64_t)buildingCount * buildingSize
+        + (uint64_t)troopCount * troopSize
+        + (uint64_t)levelCount * levelSize
+        + stringSize;
+    if (headerSize > size || (!deflated && need > size)) return false;
+    // zlib cannot expand more than ~1032:1; anything beyond that is a corrupt header.
+    if (deflated && need - headerSize > (uint64_t)(size - headerSize) * 1032) return false;
+
+    const uint32_t nameOffset = get32(h + H_NAME_OFFSET);
+    const uint32_t nameLength = get32(h + H_NAME_LENGTH);
+    if ((uint64_t)nameOffset + nameLength > stringSize) return false;
+
+    if (generation) *generation = (headerSize >= H_GENERATION + 8) ? get64(h + H_GENERATION) : 0;
+    if (updatedAt) *updatedAt = (int64_t)get64(h + H_UPDATED_AT);
+
+    out = SaveData();
+    out.slot = slot;
+    out.lastRealTime = (int64_t)get64(h + H_LAST_REAL_TIME);
+    out.gold = (int32_t)get32(h + H_GOLD);
+    out.elixir = (int32_t)get32(h + H_ELIXIR);
+    out.population = (int32_t)get32(h + H_POPULATION);
+    out.timeScale = 1.0f;
+    out.researchUnitId = (int32_t)get32(h + H_RESEARCH_UNIT);
+    out.researchTargetLevel = (int32_t)get32(h + H_RESEARCH_TARGET);
+    out.researchTotalSec = getF32(h + H_RESEARCH_TOTAL);
+    out.researchRemainSec = getF32(h + H_RESEARCH_REMAIN);
+
+    BodySource body(bytes + headerSize, size - headerSize, deflated);
+    const uint8_t* p = nullptr;
+    out.buildings.resize(buildingCount);
+    for (uint32_t i = 0; i < buildingCount; ++i)
+    {
+        if (!(p = body.take(buildingSize))) return false;
+        getBuilding(p, out.buildings[i]);
+    }
+
+    out.trainedTroops.reserve(troopCount);
+    for (uint32_t i = 0; i < troopCount; ++i)
+    {
+        if (!(p = body.take(troopSize))) return false;
+        SaveTrainedTroop t;
+        t.type = (int32_t)get32(p + 0);
+        t.r = (int32_t)get32(p + 4);
+        t.c = (int32_t)get32(p + 8);
+        if (t.type > 0) out.trainedTroops.push_back(t);
+    }
+
+    for (int id = 1; id <= 4; ++id) out.troopLevels[id] = 1;
+    for (uint32_t i = 0; i < levelCount; ++i)
+    {
+        if (!(p = body.take(levelSize))) return false;
+        const int tid = (int32_t)get32(p + 0);
+        const int tlv = (int32_t)get32(p + 4);
+        if (tid >= 1 && tid <= 4) out.troopLevels[tid] = std::max(1, tlv);
+    }
+
+    if (!(p = body.take(stringSize))) return false;
+    if (nameLength > 0) out.name.assign((const char*)p + nameOffset, nameLength);
+    else out.name = defaultName(slot);
+
+    normalize(out);
+    return true;
+}
+
+void SaveCodec::encodeJson(const SaveData& data, int64_t updatedAt, int64_t lastRealTime,
+    std::vector<uint8_t>& out)
+{
+    out.clear();
+    ByteStream os(out);
+    JsonPool::get().Clear();
+    rapidjson::Writer<ByteStream, rapidjson::UTF8<>, rapidjson::UTF8<>, JsonPool::Allocator>
+        w(os, &JsonPool::get());
+
+    w.StartObject();
+
+    w.Key("meta");
+    w.StartObject();
+    w.Key("name");
+    w.String(data.name.c_str(), (rapidjson::SizeType)data.name.size());
+    w.Key("updatedAt");
+    w.Int64(updatedAt);
+    w.Key("lastRealTime");
+    w.Int64(lastRealTime);
+    w.EndObject();
+
+    w.Key("resources");
+    w.StartObject();
+    w.Key("gold");
+    w.Int(data.gold);
+    w.Key("elixir");
+    w.Int(data.elixir);
+    w.Key("population");
+    w.Int(data.population);
+    w.EndObject();
+
+    w.Key("timeScale");
+    w.Double(1.0);
+
+    w.Key("buildings");
+    w.StartArray();
+    for (const auto& b : data.buildings)
+    {
+        w.StartObject();
+        w.Key("id");
+        w.Int(b.id);
+        w.Key("level");
+        w.Int(b.level);
+        w.Key("r");
+        w.Int(b.r);
+        w.Key("c");
+        w.Int(b.c);
+        w.Key("hp");
+        w.Int(b.hp);
+        w.Key("stored");
+        w.Double(b.stored);
+
+        w.Key("buildState");
+        w.Int(b.buildState);
+        w.Key("buildTotalSec");
+        w.Double(b.buildTotalSec);
+        w.Key("buildRemainSec");
+        w.Double(b.buildRemainSec);
+        w.Key("upgradeTargetLevel");
+        w.Int(b.upgradeTargetLevel);
+        w.EndObject();
+    }
+    w.EndArray();
+
+    w.Key("trainedTroops");
+    w.StartArray();
+    for (const auto& t : data.trainedTroops)
+    {
+        w.StartObject();
+        w.Key("type");
+        w.Int(t.type);
+        w.Key("r");
+        w.Int(t.r);
+        w.Key("c");
+        w.Int(t.c);
+        w.EndObject();
+    }
+    w.EndArray();
+
+    w.Key("troopLevels");
+    w.StartArray();
+    for (int id = 1; id <= 4; ++id)
+    {
+        w.StartObject();
+        w.Key("id");
+        w.Int(id);
+        w.Key("level");
+        w.Int(troopLevelOf(data, id));
+        w.EndObject();
+    }
+    w.EndArray();
+
+    w.Key("research");
+    w.StartObject();
+    w.Key("unitId");
+    w.Int(data.researchUnitId);
+    w.Key("targetLevel");
+    w.Int(data.researchTargetLevel);
+    w.Key("totalSec");
+    w.Double(data.researchTotalSec);
+    w.Key("remainSec");
+    w.Double(data.researchRemainSec);
+    w.EndObject();
+
+    w.EndObject();
+}
+
+bool SaveCodec::decodeJson(const uint8_t* text, size_t size, int slot, SaveData& out)
+{
+    SaveData parsed;
+    parsed.slot = slot;
+    parsed.name = defaultName(slot);
+    for (int id = 1; id <= 4; ++id) parsed.troopLevels[id] = 1;
+
+    JsonSaveHandler handler(parsed);
+    rapidjson::MemoryStream is(reinterpret_cast<const char*>(text), size);
+    JsonPool::get().Clear();
+    rapidjson::GenericReader<rapidjson::UTF8<>, rapidjson::UTF8<>, JsonPool::Allocator>
+        reader(&JsonPool::get());
+    if (reader.Parse(is, handler).IsError() || !handler.sawRoot()) return false;
+
+    parsed.timeScale = 1.0f;
+    normalize(parsed);
+    out = std::move(parsed);
+    return true;
+}
+
+void SaveCodec::encodeJournalHeader(uint64_t generation, std::vector<uint8_t>& out)
+{
+    const size_t at = out.size();
+    out.resize(at + JOURNAL_HEADER_SIZE, 0);
+    uint8_t* p = out.data() + at;
+    put32(p + 0, JOURNAL_MAGIC);
+    put16(p + 4, JOURNAL_VERSION);
+    put16(p + 6, 0);
+    put64(p + 8, generation);
+}
+
+size_t SaveCodec::encodeJournalDelta(const SaveData& before, const SaveData& after,
+    std::vector<uint8_t>& out)
+{
+    const size_t start = out.size();
+
+    if (before.gold != after.gold || before.elixir != after.elixir
+        || before.population != after.population
+        || before.researchUnitId != after.researchUnitId
+        || before.researchTargetLevel != after.researchTargetLevel
+        || before.researchTotalSec != after.researchTotalSec
+        || before.researchRemainSec != after.researchRemainSec
+        || before.lastRealTime != after.lastRealTime)
+    {
+        uint8_t* p = beginRecord(out, J_SCALARS, kScalarsPayload);
+        put32(p + 0, (uint32_t)after.gold);
+        put32(p + 4, (uint32_t)after.elixir);
+        put32(p + 8, (uint32_t)after.population);
+        put32(p + 12, (uint32_t)after.researchUnitId);
+        put32(p + 16, (uint32_t)after.researchTargetLevel);
+        putF32(p + 20, after.researchTotalSec);
+        putF32(p + 24, after.researchRemainSec);
+        put64(p + 28, (uint64_t)after.lastRealTime);
+        finishRecord(out, kScalarsPayload);
+    }
+
+    if (before.buildings.size() != after.buildings.size())
+    {
+        uint8_t* p = beginRecord(out, J_BUILDING_COUNT, 4);
+        put32(p, (uint32_t)after.buildings.size());
+        finishRecord(out, 4);
+    }
+
+    const size_t common = std::min(before.buildings.size(), after.buildings.size());
+    for (size_t i = 0; i < after.buildings.size(); ++i)
+    {
+        if (i < common && sameBuilding(before.buildings[i], after.buildings[i])) continue;
+        const size_t payload = 4 + BINARY_BUILDING_SIZE;
+        uint8_t* p = beginRecord(out, J_BUILDING, payload);
+        put32(p, (uint32_t)i);
+        putBuilding(p + 4, after.buildings[i]);
+        finishRecord(out, payload);
+    }
+
+    if (!sameTroops(before.trainedTroops, after.trainedTroops))
+    {
+        const size_t payload = 4 + after.trainedTroops.size() * BINARY_TROOP_SIZE;
+        uint8_t* p = beginRecord(out, J_TROOPS, payload);
+        put32(p, (uint32_t)after.trainedTroops.size());
+        p += 4;
+        for (const auto& t : after.trainedTroops)
+        {
+            put32(p + 0, (uint32_t)t.type);
+            put32(p + 4, (uint32_t)t.r);
+            put32(p + 8, (uint32_t)t.c);
+            p += BINARY_TROOP_SIZE;
+        }
+        finishRecord(out, payload);
+    }
+
+    bool levelsChanged = false;
+    for (int id = 1; id <= 4; ++id)
+    {
+        if (troopLevelOf(before, id) != troopLevelOf(after, id)) levelsChanged = true;
+    }
+    if (levelsChanged)
+    {
+        const size_t payload = 4 * BINARY_LEVEL_SIZE;
+        uint8_t* p = beginRecord(out, J_LEVELS, payload);
+        for (int id = 1; id <= 4; ++id)
+        {
+            put32(p + 0, (uint32_t)id);
+            put32(p + 4, (uint32_t)troopLevelOf(after, id));
+            p += BINARY_LEVEL_SIZE;
+        }
+        finishRecord(out, payload);
+    }
+
+    if (before.name != after.name)
+    {
+        const size_t payload = after.name.size();
+        uint8_t* p = beginRecord(out, J_NAME, payload);
+        if (payload > 0) std::memcpy(p, after.name.data(), payload);
+        finishRecord(out, payload);
+    }
+
+    return out.size() - start;
+}
+
+bool SaveCodec::peekJournalGeneration(const uint8_t* bytes, size_t size, uint64_t& generation)
+{
+    if (!bytes || size < JOURNAL_HEADER_SIZE || get32(bytes) != JOURNAL_MAGIC) return false;
+    generation = get64(bytes + 8);
+    return true;
+}
+
+bool SaveCodec::replayJournal(const uint8_t* bytes, size_t size, uint64_t generation,
+    SaveData& data, size_t& consumed)
+{
+    consumed = 0;
+    if (!bytes || size < JOURNAL_HEADER_SIZE || get32(bytes) != JOURNAL_MAGIC) return false;
+    if (get16(bytes + 4) != JOURNAL_VERSION || get64(bytes + 8) != generation) return false;
+
+    size_t pos = JOURNAL_HEADER_SIZE;
+    for (;;)
+    {
+        if (size - pos < kJournalRecordHeader + kJournalChecksumSize) break;
+        const uint8_t* rec = bytes + pos;
+        const uint32_t type = get16(rec);
+        const size_t payload = get32(rec + 4);
+        if (size - pos - kJournalRecordHeader - kJournalChecksumSize < payload) break;
+        const size_t total = kJournalRecordHeader + payload + kJournalChecksumSize;
+        if (get32(rec + kJournalRecordHeader + payload) != recordChecksum(rec, kJournalRecordHeader + payload)) break;
+
+        const uint8_t* p = rec + kJournalRecordHeader;
+        switch (type)
+        {
+        case J_SCALARS:
+            if (payload < kScalarsPayload) break;
+            data.gold = (int32_t)get32(p + 0);
+            data.elixir = (int32_t)get32(p + 4);
+            data.population = (int32_t)get32(p + 8);
+            data.researchUnitId = (int32_t)get32(p + 12);
+            data.researchTargetLevel = (int32_t)get32(p + 16);
+            data.researchTotalSec = getF32(p + 20);
+            data.researchRemainSec = getF32(p + 24);
+            data.lastRealTime = (int64_t)get64(p + 28);
+            break;
+        case J_BUILDING_COUNT:
+            if (payload < 4) break;
+            data.buildings.resize(get32(p));
+            break;
+        case J_BUILDING:
+        {
+            if (payload < 4 + BINARY_BUILDING_SIZE) break;
+            const uint32_t index = get32(p);
+            if (index < data.buildings.size()) getBuilding(p + 4, data.buildings[index]);
+            break;
+        }
+        case J_TROOPS:
+        {
+            if (payload < 4) break;
+            const uint32_t count = get32(p);
+            if ((payload - 4) / BINARY_TROOP_SIZE < count) break;
+            data.trainedTroops.clear();
+            data.trainedTroops.reserve(count);
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                const uint8_t* t = p + 4 + (size_t)i * BINARY_TROOP_SIZE;
+                SaveTrainedTroop troop;
+                troop.type = (int32_t)get32(t + 0);
+                troop.r = (int32_t)get32(t + 4);
+                troop.c = (int32_t)get32(t + 8);
+                if (troop.type > 0) data.trainedTroops.push_back(troop);   // as decodeBinary
+            }
+            break;
+        }
+        case J_LEVELS:
+            for (size_t off = 0; off + BINARY_LEVEL_SIZE <= payload; off += BINARY_LEVEL_SIZE)
+            {
+                const int tid = (int32_t)get32(p + off);
+                const int tlv = (int32_t)get32(p + off + 4);
+                if (tid >= 1 && tid <= 4) data.troopLevels[tid] = std::max(1, tlv);
+            }
+            break;
+        case J_NAME:
+            data.name.assign((const char*)p, payload);
+            break;
+        default:
+            break;   // unknown record from a newer build: skip it
+        }
+        pos += total;
+    }
+
+    consumed = pos;
+    normalize(data);
+    return true;
+}
+
+void SaveCodec::encodeIndex(const std::vector<SaveMeta>& metas, std::vector<uint8_t>& out)
+{
+    size_t total = 12;
+    uint32_t count = 0;
+    for (const auto& m : metas)
+    {
+        if (!m.exists) continue;
+        total += INDEX_RECORD_SIZE + m.name.size();
+        ++count;
+    }
+    out.assign(total, 0);
+
+    uint8_t* p = out.data();
+    put32(p + 0, INDEX_MAGIC);
+    put16(p + 4, INDEX_VERSION);
+    put16(p + 6, INDEX_RECORD_SIZE);
+    put32(p + 8, count);
+    p += 12;
+
+    for (const auto& m : metas)
+    {
+        if (!m.exists) continue;
+        const uint32_t nameLength = (uint32_t)m.name.size();
+        put32(p + 0, (uint32_t)m.slot);
+        put32(p + 4, (uint32_t)m.townHallLevel);
+        put32(p + 8, (uint32_t)m.lootGold);
+        put32(p + 12, (uint32_t)m.lootElixir);
+        put64(p + 16, (uint64_t)m.updatedAt);
+        put32(p + 24, nameLength);
+        p += INDEX_RECORD_SIZE;
+        if (nameLength > 0) std::memcpy(p, m.name.data(), nameLength);
+        p += nameLength;
+    }
+}
+
+bool SaveCodec::decodeIndex(const uint8_t* bytes, size_t size, std::vector<SaveMeta>& out)
+{
+    out.clear();
+    if (!bytes || size < 12 || get32(bytes) != INDEX_MAGIC) return false;
+    if (get16(bytes + 4) != INDEX_VERSION) return false;
+    const size_t recordSize = get16(bytes + 6);
+    if (recordSize < INDEX_RECORD_SIZE) return false;
+    const uint32_t count = get32(bytes + 8);
+
+    size_t pos = 12;
+    out.reserve(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (size - pos < recordSize) return false;
+        const uint8_t* p = bytes + pos;
+        SaveMeta m;
+        m.exists = true;
+        m.slot = (int32_t)get32(p + 0);
+        m.townHallLevel = (int32_t)get32(p + 4);
+        m.lootGold = (int32_t)get32(p + 8);
+        m.lootElixir = (int32_t)get32(p + 12);
+        m.updatedAt = (int64_t)get64(p + 16);
+        const uint32_t nameLength = get32(p + 24);
+        pos += recordSize;
+        if (size - pos < nameLength) return false;
+        m.name.assign((const char*)bytes + pos, nameLength);
+        pos += nameLength;
+        out.push_back(std::move(m));
+    }
+    return true;
+}
+
+void SaveCodec::normalize(SaveData& data)
+{
+    for (int id = 1; id <= 4; ++id)
+    {
+        if (data.troopLevels.find(id) == data.troopLevels.end()) data.troopLevels[id] = 1;
+    }
+
+    if (data.researchRemainSec < 0.0f) data.researchRemainSec = 0.0f;
+    if (data.researchTotalSec < 0.0f) data.researchTotalSec = 0.0f;
+    if (data.researchRemainSec > data.researchTotalSec && data.researchTotalSec > 0.0f)
+        data.researchRemainSec = data.researchTotalSec;
+    if (data.researchUnitId < 1 || data.researchUnitId > 4)
+    {
+        data.researchUnitId = 0;
+        data.researchTargetLevel = 0;
+        data.researchTotalSec = 0.0f;
+        data.researchRemainSec = 0.0f;
+    }
+}
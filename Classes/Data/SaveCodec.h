@@ -0,0 +1,123 @@
+// File: SaveCodec.h
+// Brief: Declares the SaveCodec component.
+#pragma once
+
+#include "Data/SaveSystem.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// SaveCodec converts SaveData to and from its on-disk encodings.
+//
+// Binary (the native format, version BINARY_VERSION), all fields little-endian:
+//   header        BINARY_HEADER_SIZE bytes: magic "COCS", version, flags, the size of
+//                 the header and of each record kind, record counts, the scalar
+//                 fields of SaveData and the name as (offset, length) into the
+//                 string table
+//   buildings     buildingCount fixed-size records
+//   troops        troopCount fixed-size records
+//   troop levels  levelCount (id, level) records
+//   string table  raw UTF-8 bytes
+// Readers use the sizes stored in the header, so a later version can append fields
+// to the header or to a record without breaking older files (the generation field
+// was appended that way; 88-byte headers read as generation 0).
+// With BINARY_FLAG_DEFLATE set in the header flags, everything after the header is
+// one zlib stream. Large villages are stored that way; the header itself stays plain
+// so counts and generation are readable without inflating.
+// With BINARY_FLAG_CHECKSUM set, the file ends in a CRC32C of every byte before it
+// (header and stored body); a file that fails it is treated as unreadable and
+// SaveSystem falls back to the previous generation.
+//
+// Journal (save_NNNN.jnl): a 16-byte header (magic "COCJ", version, the generation of
+// the snapshot it extends) followed by delta records. Each record is a type, a
+// payload length, the payload and a checksum; replay stops at the first torn or
+// corrupt record.
+//
+// JSON is the legacy format; it stays available for import/export and migration.
+
+namespace SaveCodec
+{
+    constexpr uint32_t BINARY_MAGIC = 0x53434F43u;   // "COCS"
+    constexpr uint16_t BINARY_VERSION = 1;
+    constexpr uint16_t BINARY_HEADER_SIZE = 96;
+    constexpr uint16_t BINARY_BUILDING_SIZE = 40;
+    constexpr uint16_t BINARY_TROOP_SIZE = 12;
+    constexpr uint16_t BINARY_LEVEL_SIZE = 8;
+    constexpr uint16_t BINARY_FLAG_DEFLATE = 1;
+    constexpr uint16_t BINARY_FLAG_CHECKSUM = 2;
+    constexpr uint16_t BINARY_KNOWN_FLAGS = BINARY_FLAG_DEFLATE | BINARY_FLAG_CHECKSUM;
+    constexpr size_t BINARY_CHECKSUM_SIZE = 4;
+    constexpr size_t BINARY_COMPRESS_MIN_BODY = 4096;   // smaller bodies are stored plain
+
+    constexpr uint32_t INDEX_MAGIC = 0x49434F43u;    // "COCI"
+    constexpr uint16_t INDEX_VERSION = 1;
+    constexpr uint16_t INDEX_RECORD_SIZE = 28;
+
+    constexpr uint32_t JOURNAL_MAGIC = 0x4A434F43u;  // "COCJ"
+    constexpr uint16_t JOURNAL_VERSION = 1;
+    constexpr size_t JOURNAL_HEADER_SIZE = 16;
+
+    // CRC32C (Castagnoli) of bytes. Uses the SSE4.2 / ARMv8 CRC instructions when
+    // the build targets them, a slice-by-8 table otherwise.
+    uint32_t crc32c(const uint8_t* bytes, size_t size);
+
+    // Returns whether bytes start with the binary magic.
+    bool isBinary(const uint8_t* bytes, size_t size);
+
+    // Serializes data into out (replaced). updatedAt and lastRealTime are stamped
+    // into the header instead of being taken from data; generation identifies the
+    // snapshot to its journal. Bodies of BINARY_COMPRESS_MIN_BODY bytes or more are
+    // deflated when that makes them smaller. A CRC32C footer is always appended.
+    void encodeBinary(const SaveData& data, int64_t updatedAt, int64_t lastRealTime,
+        uint64_t generation, std::vector<uint8_t>& out);
+
+    // Reads a binary save into out. Returns false on a bad magic, an unknown major
+    // version or flag, a checksum mismatch or a truncated file; out is only valid on
+    // success. Files written before the footer existed are read unchecked. A deflated
+    // body is inflated record by record through a small window, not as a whole.
+    // generation and updatedAt, when given, receive those header fields.
+    bool decodeBinary(const uint8_t* bytes, size_t size, int slot, SaveData& out,
+        uint64_t* generation = nullptr, int64_t* updatedAt = nullptr);
+
+    // Appends a journal header for a snapshot of the given generation to out.
+    void encodeJournalHeader(uint64_t generation, std::vector<uint8_t>& out);
+
+    // Appends the records that turn before into after to out. Buildings are compared
+    // by index, so a move, upgrade or production tick costs one fixed-size record;
+    // troops, troop levels and the name are written whole when they differ.
+    // Returns the number of bytes appended.
+    size_t encodeJournalDelta(const SaveData& before, const SaveData& after,
+        std::vector<uint8_t>& out);
+
+    // Reads the snapshot generation a journal belongs to.
+    bool peekJournalGeneration(const uint8_t* bytes, size_t size, uint64_t& generation);
+
+    // Applies a journal to data if its header matches generation. consumed receives
+    // the length of the valid prefix (header plus whole, intact records). Returns
+    // false if the header does not belong to this snapshot.
+    bool replayJournal(const uint8_t* bytes, size_t size, uint64_t generation,
+        SaveData& data, size_t& consumed);
+
+    // Serializes data as legacy JSON text into out, replacing its content. The text
+    // is streamed by a rapidjson Writer; out's capacity is reused across calls.
+    void encodeJson(const SaveData& data, int64_t updatedAt, int64_t lastRealTime,
+        std::vector<uint8_t>& out);
+
+    // Parses legacy JSON text into out with a SAX handler (no DOM is built). out is
+    // left untouched on failure. encodeJson and decodeJson share a scratch
+    // allocator, so both are main-thread only.
+    bool decodeJson(const uint8_t* text, size_t size, int slot, SaveData& out);
+
+    // Serializes the slot index: a 12-byte header (magic, version, record size,
+    // count) and, per existing slot, a fixed record followed by the name bytes.
+    void encodeIndex(const std::vector<SaveMeta>& metas, std::vector<uint8_t>& out);
+
+    // Reads a slot index; entries get exists = true. Returns false if the data is
+    // not a complete index of this version.
+    bool decodeIndex(const uint8_t* bytes, size_t size, std::vector<SaveMeta>& out);
+
+    // Fills defaults and clamps fields shared by every format (troop levels 1..4,
+    // research timers).
+    void normalize(SaveData& data);
+}
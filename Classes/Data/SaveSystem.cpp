@@ -1,19 +1,129 @@
 // File: SaveSystem.cpp
 // Brief: Implements the SaveSystem component.
 #include "Data/SaveSystem.h"
+#include "Data/SaveCodec.h"
+#include "Data/SaveWorker.h"
 #include "cocos2d.h"
-#include "json/document.h"
-#include "json/stringbuffer.h"
-#include "json/writer.h"
 #include <ctime>
 #include <cstdio>
+#include <algorithm>
+#include <unordered_set>
 
 USING_NS_CC;
 
+namespace {
+
+// The journal is folded back into a new snapshot once it would grow past the larger
+// of the snapshot size and this floor. Replay thus reads at most about one extra
+// snapshot's worth of bytes; small villages may carry a few KB more than that so
+// they are not compacted on nearly every save.
+const size_t kJournalMinCompactBytes = 4 * 1024;
+
+// At most this many slots keep their decoded state in memory; see trimCache.
+const size_t kMaxCachedSlots = 8;
+
+// SlotJournal is what SaveSystem knows about a slot's files: the state they decode
+// to (base), the snapshot generation and how much journal sits on top of it. base
+// doubles as the slot's read cache: SaveSystem is the only writer of the save
+// directory, so once known it stays valid until the next save() or remove().
+struct SlotJournal {
+    bool known = false;
+    SaveData base;
+    uint64_t generation = 0;
+    size_t snapshotBytes = 0;
+    size_t journalBytes = 0;        // 0 = no valid journal; the next append starts one
+    bool needsCompaction = false;   // torn journal tail: rewrite before appending again
+};
+
+std::unordered_map<int, SlotJournal> s_journals;
+std::vector<uint8_t> s_journalScratch;
+std::vector<uint8_t> s_jsonScratch;
+std::vector<bool> s_shardReady;   // shard directories known to exist
+SaveCacheStats s_cacheStats;
+std::unordered_set<int> s_failedSlots;   // background writes failed, see takeWriteFailure
+std::vector<int> s_failedScratch;
+
+// Picks up the slots the SaveWorker failed to write. Their files no longer match
+// what SlotJournal assumes (a snapshot generation that never landed, or a journal
+// with a torn record in the middle), so the next save rewrites a full snapshot.
+void collectWorkerFailures()
+{
+    SaveWorker::takeFailedSlots(s_failedScratch);
+    for (int slot : s_failedScratch)
+    {
+        auto it = s_journals.find(slot);
+        if (it != s_journals.end() && it->second.known) it->second.needsCompaction = true;
+        s_failedSlots.insert(slot);
+    }
+}
+
+// Reads a slot's binary snapshot (or its backup) and replays the journal on top.
+// Fills j with what the files say but leaves j.base to the caller, which decides
+// whether the slot is worth caching. updatedAt, when given, receives the time of
+// the last save. Returns false if the slot has no binary files.
+bool readSlotFiles(int slot, SaveData& outData, SlotJournal& j, int64_t* updatedAt = nullptr)
+{
+    auto fu = FileUtils::getInstance();
+    std::string path = SaveSystem::getSavePath(slot);
+    std::string backup = SaveSystem::getBackupPath(slot);
+    if (!fu->isFileExist(path) && !fu->isFileExist(backup)) return false;
+
+    uint64_t generation = 0;
+    int64_t snapshotTime = 0;
+    auto readSnapshot = [&](const std::string& file, Data& bytes) {
+        if (!fu->isFileExist(file)) return false;
+        bytes = fu->getDataFromFile(file);
+        return !bytes.isNull()
+            && SaveCodec::decodeBinary(bytes.getBytes(), (size_t)bytes.getSize(), slot, outData,
+                &generation, &snapshotTime);
+    };
+
+    Data bytes;
+    if (!readSnapshot(path, bytes))
+    {
+        // Missing or failing its checksum: fall back to the previous generation and
+        // put it back in place. The journal belongs to the lost snapshot unless the
+        // crash came before the new one was renamed in, which the generation check
+        // below sorts out.
+        if (!readSnapshot(backup, bytes)) return false;
+        CCLOG("[SaveSystem] Slot %d: snapshot unreadable, restored the previous generation", slot);
+        SaveWorker::writeAtomic(path, bytes.getBytes(), (size_t)bytes.getSize());
+    }
+
+    j = SlotJournal();
+    j.known = true;
+    j.generation = generation;
+    j.snapshotBytes = (size_t)bytes.getSize();
+
+    // A journal written for an older snapshot (crash during compaction) fails the
+    // generation check and is ignored.
+    std::string journal = SaveSystem::getJournalPath(slot);
+    if (fu->isFileExist(journal))
+    {
+        Data jb = fu->getDataFromFile(journal);
+        size_t consumed = 0;
+        if (!jb.isNull()
+            && SaveCodec::replayJournal(jb.getBytes(), (size_t)jb.getSize(), generation, outData, consumed))
+        {
+            j.journalBytes = consumed;
+            j.needsCompaction = consumed < (size_t)jb.getSize();
+        }
+    }
+    // Journaled saves stamp lastRealTime with the save time; a migrated or imported
+    // snapshot keeps an older lastRealTime than the updatedAt in its header.
+    if (updatedAt) *updatedAt = std::max(snapshotTime, outData.lastRealTime);
+    return true;
+}
+
+}  // namespace
+
 int SaveSystem::s_currentSlot = 0;
 int SaveSystem::s_battleTargetSlot = -1;
 std::unordered_map<int, int> SaveSystem::s_battleReadyTroops;
 std::unordered_map<int, int> SaveSystem::s_battleTroopLevels;
+std::unordered_map<int, SaveMeta> SaveSystem::s_index;
+std::vector<int> SaveSystem::s_order;
+bool SaveSystem::s_indexLoaded = false;
 
 void SaveSystem::setCurrentSlot(int slot)
 {
@@ -42,271 +152,502 @@ std::string SaveSystem::getSaveDir()
     return dir;
 }
 
-std::string SaveSystem::getSavePath(int slot)
+std::string SaveSystem::getShardDir(int shard)
 {
-    char buf[32];
-    snprintf(buf, sizeof(buf), "save_%02d.json", slot);
+    char buf[16];
+    snprintf(buf, sizeof(buf), "s%03d/", shard);
     return getSaveDir() + buf;
 }
 
+std::string SaveSystem::getSlotPath(int slot, const char* ext)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), "save_%04d.%s", slot, ext);
+    return getShardDir(slot / kSlotsPerShard) + buf;
+}
+
+std::string SaveSystem::getSavePath(int slot)
+{
+    return getSlotPath(slot, "sav");
+}
+
+std::string SaveSystem::getJsonPath(int slot)
+{
+    return getSlotPath(slot, "json");
+}
+
+std::string SaveSystem::getBackupPath(int slot)
+{
+    return getSlotPath(slot, "bak");
+}
+
+std::string SaveSystem::getJournalPath(int slot)
+{
+    return getSlotPath(slot, "jnl");
+}
+
+void SaveSystem::ensureShardDir(int slot)
+{
+    const int shard = slot / kSlotsPerShard;
+    if (s_shardReady.empty()) s_shardReady.assign(kMaxSlots / kSlotsPerShard, false);
+    if (s_shardReady[shard]) return;
+    FileUtils::getInstance()->createDirectory(getShardDir(shard));
+    s_shardReady[shard] = true;
+}
+
 bool SaveSystem::exists(int slot)
 {
     if (slot < 0 || slot >= kMaxSlots) return false;
-    return FileUtils::getInstance()->isFileExist(getSavePath(slot));
+    auto it = s_journals.find(slot);
+    if (it != s_journals.end() && it->second.known) return true;
+    ensureIndex();
+    return s_index.count(slot) > 0;
+}
+
+SaveCacheStats SaveSystem::getCacheStats()
+{
+    return s_cacheStats;
 }
 
-std::vector<SaveMeta> SaveSystem::listAllSlots()
+void SaveSystem::resetCacheStats()
 {
+    s_cacheStats = SaveCacheStats();
+}
+
+int SaveSystem::countSlots(int excludeSlot)
+{
+    ensureIndex();
+    return (int)s_order.size() - (int)s_index.count(excludeSlot);
+}
+
+std::vector<SaveMeta> SaveSystem::listSlots(int offset, int count, int excludeSlot)
+{
+    ensureIndex();
     std::vector<SaveMeta> metas;
-    metas.reserve(kMaxSlots);
-    for (int i = 0; i < kMaxSlots; ++i)
+    if (offset < 0 || count <= 0) return metas;
+
+    // Position in s_order of the first entry of the page, stepping over excludeSlot
+    // if it sits before it.
+    size_t pos = (size_t)offset;
+    if (s_index.count(excludeSlot))
     {
-        SaveMeta meta;
-        meta.slot = i;
-        meta.path = getSavePath(i);
-        meta.exists = exists(i);
-        meta.name = cocos2d::StringUtils::format("Save %02d", i + 1);
-        if (meta.exists)
-        {
-            SaveData tmp;
-            if (load(i, tmp))
-            {
-                meta.name = tmp.name.empty() ? meta.name : tmp.name;
-            }
-        }
-        metas.push_back(meta);
+        const size_t skipAt = std::lower_bound(s_order.begin(), s_order.end(), excludeSlot) - s_order.begin();
+        if (skipAt <= pos) ++pos;
+    }
+
+    metas.reserve((size_t)count);
+    for (; pos < s_order.size() && (int)metas.size() < count; ++pos)
+    {
+        if (s_order[pos] == excludeSlot) continue;
+        SaveMeta meta = s_index[s_order[pos]];
+        meta.path = getSavePath(meta.slot);
+        if (meta.name.empty()) meta.name = cocos2d::StringUtils::format("Save %02d", meta.slot + 1);
+        metas.push_back(std::move(meta));
     }
     return metas;
 }
 
+SaveMeta SaveSystem::getSlotMeta(int slot)
+{
+    ensureIndex();
+    auto it = s_index.find(slot);
+    if (it != s_index.end()) return it->second;
+    SaveMeta meta;
+    meta.slot = slot;
+    return meta;
+}
+
+int SaveSystem::findFreeSlot()
+{
+    ensureIndex();
+    // s_order is ascending and duplicate-free, so s_order[i] == i holds exactly for a
+    // prefix; the first slot missing is where that prefix ends.
+    size_t lo = 0, hi = s_order.size();
+    while (lo < hi)
+    {
+        const size_t mid = (lo + hi) / 2;
+        if (s_order[mid] == (int)mid) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo < (size_t)kMaxSlots ? (int)lo : -1;
+}
+
 bool SaveSystem::load(int slot, SaveData& outData)
 {
     if (slot < 0 || slot >= kMaxSlots) return false;
-    std::string path = getSavePath(slot);
-    if (!FileUtils::getInstance()->isFileExist(path)) return false;
-    std::string content = FileUtils::getInstance()->getStringFromFile(path);
-    rapidjson::Document doc;
-    doc.Parse<0>(content.c_str());
-    if (doc.HasParseError() || !doc.IsObject()) return false;
-
-    outData = SaveData();
-    outData.slot = slot;
-    outData.name = cocos2d::StringUtils::format("Save %02d", slot + 1);
-
-    if (doc.HasMember("meta") && doc["meta"].IsObject())
+    auto cached = s_journals.find(slot);
+    if (cached != s_journals.end() && cached->second.known)
     {
-        const auto& meta = doc["meta"];
-        if (meta.HasMember("name") && meta["name"].IsString())
-        {
-            outData.name = meta["name"].GetString();
-        }
-        
-        if (meta.HasMember("lastRealTime") && meta["lastRealTime"].IsInt64())
-        {
-            outData.lastRealTime = meta["lastRealTime"].GetInt64();
-        }
+        ++s_cacheStats.hits;
+        outData = cached->second.base;
+        return true;
     }
+    ++s_cacheStats.misses;
 
-    if (doc.HasMember("resources") && doc["resources"].IsObject())
+    ensureIndex();   // also moves slots of the old flat layout into their shards
+    SaveWorker::flush();
+    SlotJournal j;
+    if (readSlotFiles(slot, outData, j))
     {
-        const auto& res = doc["resources"];
-        if (res.HasMember("gold") && res["gold"].IsInt()) outData.gold = res["gold"].GetInt();
-        if (res.HasMember("elixir") && res["elixir"].IsInt()) outData.elixir = res["elixir"].GetInt();
-        if (res.HasMember("population") && res["population"].IsInt()) outData.population = res["population"].GetInt();
+        trimCache(slot);
+        j.base = outData;
+        s_journals[slot] = std::move(j);
+        return true;
     }
+    return migrateJson(slot, outData);
+}
 
-    
-    
-    
-    
-    outData.timeScale = 1.0f;
+bool SaveSystem::save(const SaveData& data)
+{
+    if (data.slot < 0 || data.slot >= kMaxSlots) return false;
+    const int64_t now = static_cast<int64_t>(std::time(nullptr));
+    return writeBinary(data, now, now);
+}
+
+bool SaveSystem::saveAsync(SaveData&& data)
+{
+    if (data.slot < 0 || data.slot >= kMaxSlots) return false;
+    const int64_t now = static_cast<int64_t>(std::time(nullptr));
+    const int slot = data.slot;
+    data.lastRealTime = now;
+
+    collectWorkerFailures();
+
+    // The index entry is updated right away so listSlots already shows it.
+    ensureIndex();
+    ensureShardDir(slot);
+    setIndexEntry(makeMeta(data, now));
+
+    // load() caches the slot if it has files; a new slot gets its entry below, after
+    // room was made for it.
+    auto cached = s_journals.find(slot);
+    if (cached == s_journals.end() || !cached->second.known)
+    {
+        SaveData onDisk;
+        load(slot, onDisk);
+    }
+    trimCache(slot);
+    SlotJournal& j = s_journals[slot];
 
-    if (doc.HasMember("buildings") && doc["buildings"].IsArray())
+    // Normal case: append what changed since the last save.
+    if (j.known && !j.needsCompaction)
     {
-        const auto& arr = doc["buildings"];
-        for (rapidjson::SizeType i = 0; i < arr.Size(); ++i)
+        s_journalScratch.clear();
+        const bool fresh = j.journalBytes == 0;
+        if (fresh) SaveCodec::encodeJournalHeader(j.generation, s_journalScratch);
+        const size_t delta = SaveCodec::encodeJournalDelta(j.base, data, s_journalScratch);
+        if (j.journalBytes + s_journalScratch.size() <= std::max(kJournalMinCompactBytes, j.snapshotBytes))
         {
-            const auto& v = arr[i];
-            if (!v.IsObject()) continue;
-            if (!v.HasMember("id") || !v.HasMember("level") || !v.HasMember("r") || !v.HasMember("c")) continue;
-            SaveBuilding b;
-            if (v["id"].IsInt()) b.id = v["id"].GetInt();
-            if (v["level"].IsInt()) b.level = v["level"].GetInt();
-            if (v["r"].IsInt()) b.r = v["r"].GetInt();
-            if (v["c"].IsInt()) b.c = v["c"].GetInt();
-            if (v.HasMember("hp") && v["hp"].IsInt()) b.hp = v["hp"].GetInt();
-            if (v.HasMember("stored") && v["stored"].IsNumber()) b.stored = v["stored"].GetFloat();
-
-            
-            if (v.HasMember("buildState") && v["buildState"].IsInt()) b.buildState = v["buildState"].GetInt();
-            if (v.HasMember("buildTotalSec") && v["buildTotalSec"].IsNumber()) b.buildTotalSec = v["buildTotalSec"].GetFloat();
-            if (v.HasMember("buildRemainSec") && v["buildRemainSec"].IsNumber()) b.buildRemainSec = v["buildRemainSec"].GetFloat();
-            if (v.HasMember("upgradeTargetLevel") && v["upgradeTargetLevel"].IsInt()) b.upgradeTargetLevel = v["upgradeTargetLevel"].GetInt();
-            outData.buildings.push_back(b);
+            if (delta > 0)
+            {
+                SaveWorker::append(slot, s_journalScratch, fresh, getJournalPath(slot));
+                j.journalBytes += s_journalScratch.size();
+            }
+            j.base = std::move(data);
+            writeIndexPage(slot / kSlotsPerShard, true);
+            return true;
         }
     }
 
-    
+    // First save of a new slot, or compaction: write a full snapshot under a new
+    // generation; the worker drops the old journal once it is on disk.
+    j.generation = j.known ? j.generation + 1 : journalGeneration(slot) + 1;
+    j.known = true;
+    j.snapshotBytes = SaveCodec::BINARY_HEADER_SIZE + data.buildings.size() * SaveCodec::BINARY_BUILDING_SIZE;
+    j.journalBytes = 0;
+    j.needsCompaction = false;
+    j.base = data;
+    SaveWorker::submit(std::move(data), now, j.generation, getSavePath(slot), getBackupPath(slot),
+        getJournalPath(slot));
+    writeIndexPage(slot / kSlotsPerShard, true);
+    return true;
+}
 
-if (doc.HasMember("trainedTroops") && doc["trainedTroops"].IsArray())
+bool SaveSystem::takeWriteFailure(int slot)
 {
-    const auto& arr = doc["trainedTroops"];
-    for (rapidjson::SizeType i = 0; i < arr.Size(); ++i)
-    {
-        const auto& it = arr[i];
-        if (!it.IsObject()) continue;
-
-        SaveTrainedTroop t;
-        if (it.HasMember("type") && it["type"].IsInt()) t.type = it["type"].GetInt();
-        if (it.HasMember("r") && it["r"].IsInt()) t.r = it["r"].GetInt();
-        if (it.HasMember("c") && it["c"].IsInt()) t.c = it["c"].GetInt();
-        if (t.type > 0) outData.trainedTroops.push_back(t);
-    }
+    collectWorkerFailures();
+    return s_failedSlots.erase(slot) > 0;
 }
 
+bool SaveSystem::exportJson(int slot, const std::string& path)
+{
+    SaveData data;
+    if (!load(slot, data)) return false;
+    SaveCodec::encodeJson(data, static_cast<int64_t>(std::time(nullptr)), data.lastRealTime, s_jsonScratch);
+    return SaveWorker::writeAtomic(path, s_jsonScratch.data(), s_jsonScratch.size());
+}
 
-    
-    outData.troopLevels.clear();
-    
-    for (int id = 1; id <= 4; ++id) outData.troopLevels[id] = 1;
+bool SaveSystem::importJson(int slot, const std::string& path)
+{
+    if (slot < 0 || slot >= kMaxSlots) return false;
+    auto fu = FileUtils::getInstance();
+    if (!fu->isFileExist(path)) return false;
+    Data text = fu->getDataFromFile(path);
+    SaveData data;
+    if (text.isNull() || !SaveCodec::decodeJson(text.getBytes(), (size_t)text.getSize(), slot, data))
+        return false;
+    return writeBinary(data, static_cast<int64_t>(std::time(nullptr)), data.lastRealTime);
+}
+
+bool SaveSystem::writeBinary(const SaveData& data, int64_t updatedAt, int64_t lastRealTime)
+{
+    ensureIndex();
+    SaveWorker::flush();
+    trimCache(data.slot);
+    SlotJournal& j = s_journals[data.slot];
+    const uint64_t generation = j.known ? j.generation + 1 : journalGeneration(data.slot) + 1;
+
+    std::vector<uint8_t> bytes;
+    SaveCodec::encodeBinary(data, updatedAt, lastRealTime, generation, bytes);
+    ensureShardDir(data.slot);
+    if (!SaveWorker::writeAtomic(getSavePath(data.slot), bytes.data(), bytes.size(), getBackupPath(data.slot)))
+        return false;
+    FileUtils::getInstance()->removeFile(getJournalPath(data.slot));
+
+    j.known = true;
+    j.generation = generation;
+    j.snapshotBytes = bytes.size();
+    j.journalBytes = 0;
+    j.needsCompaction = false;
+    j.base = data;
+    j.base.lastRealTime = lastRealTime;
+
+    setIndexEntry(makeMeta(data, updatedAt));
+    writeIndexPage(data.slot / kSlotsPerShard, false);
+    return true;
+}
+
+uint64_t SaveSystem::journalGeneration(int slot)
+{
+    // Only needed before the slot was loaded: the new snapshot must not carry the
+    // generation of a journal that is still on disk.
+    auto fu = FileUtils::getInstance();
+    std::string journal = getJournalPath(slot);
+    if (!fu->isFileExist(journal)) return 0;
+    Data jb = fu->getDataFromFile(journal);
+    uint64_t generation = 0;
+    if (jb.isNull() || !SaveCodec::peekJournalGeneration(jb.getBytes(), (size_t)jb.getSize(), generation)) return 0;
+    return generation;
+}
 
-    if (doc.HasMember("troopLevels") && doc["troopLevels"].IsArray())
+bool SaveSystem::migrateJson(int slot, SaveData& outData)
+{
+    auto fu = FileUtils::getInstance();
+    std::string legacy = getJsonPath(slot);
+    if (!fu->isFileExist(legacy)) return false;
+    Data text = fu->getDataFromFile(legacy);
+    if (text.isNull() || !SaveCodec::decodeJson(text.getBytes(), (size_t)text.getSize(), slot, outData))
+        return false;
+
+    // Keep lastRealTime so offline progress survives the conversion. The JSON file
+    // is only dropped once the binary copy is on disk.
+    if (writeBinary(outData, static_cast<int64_t>(std::time(nullptr)), outData.lastRealTime))
     {
-        const auto& arr = doc["troopLevels"];
-        for (rapidjson::SizeType i = 0; i < arr.Size(); ++i)
-        {
-            const auto& it = arr[i];
-            if (!it.IsObject()) continue;
-            if (!it.HasMember("id") || !it.HasMember("level")) continue;
-            if (!it["id"].IsInt() || !it["level"].IsInt()) continue;
-            int tid = it["id"].GetInt();
-            int tlv = it["level"].GetInt();
-            if (tid >= 1 && tid <= 4) outData.troopLevels[tid] = std::max(1, tlv);
-        }
+        fu->removeFile(legacy);
     }
+    return true;
+}
 
-    
-    outData.researchUnitId = 0;
-    outData.researchTargetLevel = 0;
-    outData.researchTotalSec = 0.0f;
-    outData.researchRemainSec = 0.0f;
-    if (doc.HasMember("research") && doc["research"].IsObject())
+bool SaveSystem::remove(int slot)
+{
+    if (slot < 0 || slot >= kMaxSlots) return false;
+    ensureIndex();
+    SaveWorker::flush();
+    auto fu = FileUtils::getInstance();
+    bool removed = false;
+    if (fu->isFileExist(getSavePath(slot))) removed = fu->removeFile(getSavePath(slot));
+    if (fu->isFileExist(getJsonPath(slot))) removed = fu->removeFile(getJsonPath(slot)) || removed;
+    if (fu->isFileExist(getJournalPath(slot))) fu->removeFile(getJournalPath(slot));
+    if (fu->isFileExist(getBackupPath(slot))) fu->removeFile(getBackupPath(slot));
+    s_journals.erase(slot);
+    s_failedSlots.erase(slot);
+
+    if (s_index.erase(slot))
     {
-        const auto& r = doc["research"];
-        if (r.HasMember("unitId") && r["unitId"].IsInt()) outData.researchUnitId = r["unitId"].GetInt();
-        if (r.HasMember("targetLevel") && r["targetLevel"].IsInt()) outData.researchTargetLevel = r["targetLevel"].GetInt();
-        if (r.HasMember("totalSec") && r["totalSec"].IsNumber()) outData.researchTotalSec = r["totalSec"].GetFloat();
-        if (r.HasMember("remainSec") && r["remainSec"].IsNumber()) outData.researchRemainSec = r["remainSec"].GetFloat();
-
-        
-        if (outData.researchRemainSec < 0.0f) outData.researchRemainSec = 0.0f;
-        if (outData.researchTotalSec < 0.0f) outData.researchTotalSec = 0.0f;
-        if (outData.researchRemainSec > outData.researchTotalSec && outData.researchTotalSec > 0.0f)
-            outData.researchRemainSec = outData.researchTotalSec;
-        if (outData.researchUnitId < 1 || outData.researchUnitId > 4)
-        {
-            outData.researchUnitId = 0;
-            outData.researchTargetLevel = 0;
-            outData.researchTotalSec = 0.0f;
-            outData.researchRemainSec = 0.0f;
-        }
+        s_order.erase(std::lower_bound(s_order.begin(), s_order.end(), slot));
+        writeIndexPage(slot / kSlotsPerShard, false);
     }
+    return removed;
+}
 
-return true;
+std::string SaveSystem::getIndexPath(int shard)
+{
+    return getShardDir(shard) + "index";
 }
 
-bool SaveSystem::save(const SaveData& data)
+SaveMeta SaveSystem::makeMeta(const SaveData& data, int64_t updatedAt)
 {
-    if (data.slot < 0 || data.slot >= kMaxSlots) return false;
+    SaveMeta meta;
+    meta.slot = data.slot;
+    meta.exists = true;
+    meta.name = data.name;
+    meta.updatedAt = updatedAt;
+
+    // Same split BattleScene uses: half of the bank plus half of what sits in
+    // mines (5) and collectors (3).
+    int mineGold = 0;
+    int collectorElixir = 0;
+    for (const auto& b : data.buildings)
+    {
+        if (b.id == 9) meta.townHallLevel = std::max(meta.townHallLevel, b.level);
+        else if (b.id == 5) mineGold += (int)std::max(0.0f, b.stored);
+        else if (b.id == 3) collectorElixir += (int)std::max(0.0f, b.stored);
+    }
+    meta.lootGold = std::max(0, (data.gold + mineGold) / 2);
+    meta.lootElixir = std::max(0, (data.elixir + collectorElixir) / 2);
+    return meta;
+}
 
-    rapidjson::Document doc;
-    doc.SetObject();
-    auto& alloc = doc.GetAllocator();
+void SaveSystem::ensureIndex()
+{
+    if (s_indexLoaded) return;
+    s_indexLoaded = true;
+    if (s_shardReady.empty()) s_shardReady.assign(kMaxSlots / kSlotsPerShard, false);
 
-    rapidjson::Value meta(rapidjson::kObjectType);
-    meta.AddMember("name", rapidjson::Value(data.name.c_str(), alloc), alloc);
-    meta.AddMember("updatedAt", static_cast<int64_t>(std::time(nullptr)), alloc);
-    
-    meta.AddMember("lastRealTime", static_cast<int64_t>(std::time(nullptr)), alloc);
-    doc.AddMember("meta", meta, alloc);
+    migrateLegacyLayout();
 
-    rapidjson::Value res(rapidjson::kObjectType);
-    res.AddMember("gold", data.gold, alloc);
-    res.AddMember("elixir", data.elixir, alloc);
-    res.AddMember("population", data.population, alloc);
-    doc.AddMember("resources", res, alloc);
+    // One small page per shard directory that exists; empty shards cost one stat.
+    auto fu = FileUtils::getInstance();
+    for (int shard = 0; shard < kMaxSlots / kSlotsPerShard; ++shard)
+    {
+        if (!fu->isDirectoryExist(getShardDir(shard))) continue;
+        s_shardReady[shard] = true;
 
-    
-    doc.AddMember("timeScale", 1.0, alloc);
+        std::string path = getIndexPath(shard);
+        std::vector<SaveMeta> entries;
+        bool ok = false;
+        if (fu->isFileExist(path))
+        {
+            Data bytes = fu->getDataFromFile(path);
+            ok = !bytes.isNull()
+                && SaveCodec::decodeIndex(bytes.getBytes(), (size_t)bytes.getSize(), entries);
+        }
+        if (!ok)
+        {
+            rebuildIndexPage(shard);
+            continue;
+        }
 
-    rapidjson::Value arr(rapidjson::kArrayType);
-    for (const auto& b : data.buildings)
-    {
-        rapidjson::Value obj(rapidjson::kObjectType);
-        obj.AddMember("id", b.id, alloc);
-        obj.AddMember("level", b.level, alloc);
-        obj.AddMember("r", b.r, alloc);
-        obj.AddMember("c", b.c, alloc);
-        obj.AddMember("hp", b.hp, alloc);
-        obj.AddMember("stored", b.stored, alloc);
-
-        obj.AddMember("buildState", b.buildState, alloc);
-        obj.AddMember("buildTotalSec", b.buildTotalSec, alloc);
-        obj.AddMember("buildRemainSec", b.buildRemainSec, alloc);
-        obj.AddMember("upgradeTargetLevel", b.upgradeTargetLevel, alloc);
-        arr.PushBack(obj, alloc);
+        for (auto& m : entries)
+        {
+            if (m.slot / kSlotsPerShard != shard || m.slot < 0) continue;
+            setIndexEntry(m);
+        }
     }
-    doc.AddMember("buildings", arr, alloc);
+}
 
+void SaveSystem::rebuildIndexPage(int shard)
+{
+    // Slots are decoded into a local instead of going through load(), so rebuilding
+    // the index does not pull every village of the shard into the slot cache. A
+    // legacy JSON slot is only read here; load() converts it when it is opened.
+    SaveWorker::flush();
+    auto fu = FileUtils::getInstance();
+    const int first = shard * kSlotsPerShard;
+    for (int i = first; i < first + kSlotsPerShard; ++i)
+    {
+        SaveData data;
+        SlotJournal files;
+        int64_t updatedAt = 0;
+        bool ok = readSlotFiles(i, data, files, &updatedAt);
+        if (!ok && fu->isFileExist(getJsonPath(i)))
+        {
+            Data text = fu->getDataFromFile(getJsonPath(i));
+            ok = !text.isNull() && SaveCodec::decodeJson(text.getBytes(), (size_t)text.getSize(), i, data);
+            updatedAt = data.lastRealTime;
+        }
+        if (ok) setIndexEntry(makeMeta(data, updatedAt));
+    }
+    writeIndexPage(shard, false);
+}
 
-rapidjson::Value tArr(rapidjson::kArrayType);
-for (const auto& t : data.trainedTroops)
+void SaveSystem::trimCache(int keepSlot)
 {
-    rapidjson::Value o(rapidjson::kObjectType);
-    o.AddMember("type", t.type, alloc);
-    o.AddMember("r", t.r, alloc);
-    o.AddMember("c", t.c, alloc);
-    tArr.PushBack(o, alloc);
+    if (s_journals.count(keepSlot)) return;
+    // Drop slots other than those the scenes are working on until keepSlot fits. An
+    // evicted slot is simply read from its files again; load() flushes the worker first.
+    auto it = s_journals.begin();
+    while (s_journals.size() >= kMaxCachedSlots && it != s_journals.end())
+    {
+        if (it->first == s_currentSlot || it->first == s_battleTargetSlot) ++it;
+        else it = s_journals.erase(it);
+    }
 }
-doc.AddMember("trainedTroops", tArr, alloc);
 
+void SaveSystem::releaseCache(int slot)
+{
+    if (slot == s_currentSlot) return;
+    s_journals.erase(slot);
+}
 
-    
-    rapidjson::Value lvArr(rapidjson::kArrayType);
-    
-    std::unordered_map<int,int> levels = data.troopLevels;
-    for (int id = 1; id <= 4; ++id) {
-        if (levels.find(id) == levels.end()) levels[id] = 1;
+void SaveSystem::migrateLegacyLayout()
+{
+    // Before sharding, slots 0-19 lived directly in saves/ as save_NN.* next to a
+    // single index file. Move them into their shard; the index is rebuilt from them.
+    auto fu = FileUtils::getInstance();
+    const std::string dir = getSaveDir();
+    const std::string marker = dir + "layout";
+    if (fu->isFileExist(marker)) return;
+
+    static const char* const kExts[] = { "sav", "bak", "jnl", "json" };
+    bool moved = false;
+    bool failed = false;
+    for (int slot = 0; slot < 20; ++slot)
+    {
+        for (const char* ext : kExts)
+        {
+            char buf[32];
+            snprintf(buf, sizeof(buf), "save_%02d.%s", slot, ext);
+            const std::string legacy = dir + buf;
+            if (!fu->isFileExist(legacy)) continue;
+            ensureShardDir(slot);
+            if (fu->renameFile(legacy, getSlotPath(slot, ext))) moved = true;
+            else
+            {
+                CCLOG("[SaveSystem] Failed to move %s into its shard", legacy.c_str());
+                failed = true;
+            }
+        }
     }
-    for (int id = 1; id <= 4; ++id)
+    if (moved)
     {
-        rapidjson::Value o(rapidjson::kObjectType);
-        o.AddMember("id", id, alloc);
-        o.AddMember("level", levels[id], alloc);
-        lvArr.PushBack(o, alloc);
+        // The moved slots have no page yet; dropping it makes ensureIndex rebuild it.
+        fu->removeFile(getIndexPath(0));
     }
-    doc.AddMember("troopLevels", lvArr, alloc);
-
-    
-    rapidjson::Value rObj(rapidjson::kObjectType);
-    rObj.AddMember("unitId", data.researchUnitId, alloc);
-    rObj.AddMember("targetLevel", data.researchTargetLevel, alloc);
-    rObj.AddMember("totalSec", data.researchTotalSec, alloc);
-    rObj.AddMember("remainSec", data.researchRemainSec, alloc);
-    doc.AddMember("research", rObj, alloc);
-
+    if (fu->isFileExist(dir + "index")) fu->removeFile(dir + "index");
+    // Without the marker the next launch retries whatever could not be moved.
+    if (!failed) fu->writeStringToFile("2", marker);
+}
 
-    rapidjson::StringBuffer buffer;
-    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
-    doc.Accept(writer);
-    std::string output = buffer.GetString();
-    return FileUtils::getInstance()->writeStringToFile(output, getSavePath(data.slot));
+void SaveSystem::setIndexEntry(const SaveMeta& meta)
+{
+    auto inserted = s_index.insert(std::make_pair(meta.slot, meta));
+    if (!inserted.second)
+    {
+        inserted.first->second = meta;
+        return;
+    }
+    s_order.insert(std::upper_bound(s_order.begin(), s_order.end(), meta.slot), meta.slot);
 }
 
-bool SaveSystem::remove(int slot)
+bool SaveSystem::writeIndexPage(int shard, bool async)
 {
-    if (slot < 0 || slot >= kMaxSlots) return false;
-    return FileUtils::getInstance()->removeFile(getSavePath(slot));
+    const int first = shard * kSlotsPerShard;
+    auto begin = std::lower_bound(s_order.begin(), s_order.end(), first);
+    auto end = std::lower_bound(begin, s_order.end(), first + kSlotsPerShard);
+    std::vector<SaveMeta> page;
+    page.reserve(end - begin);
+    for (auto it = begin; it != end; ++it) page.push_back(s_index[*it]);
+
+    if (async)
+    {
+        SaveWorker::submitIndex(page, getIndexPath(shard));
+        return true;
+    }
+    SaveWorker::flush();
+    std::vector<uint8_t> bytes;
+    SaveCodec::encodeIndex(page, bytes);
+    return SaveWorker::writeAtomic(getIndexPath(shard), bytes.data(), bytes.size());
 }
 
 SaveData SaveSystem::makeDefault(int slot, const std::string& name)
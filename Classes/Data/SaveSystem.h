@@ -17,6 +17,9 @@ struct SaveMeta
     std::string name;
     std::string path;
     int64_t updatedAt = 0;
+    int townHallLevel = 0;
+    int lootGold = 0;     // gold an attacker could take (half of bank + mines)
+    int lootElixir = 0;   // elixir an attacker could take (half of bank + collectors)
 };
 
 // SaveBuilding encapsulates related behavior and state.
@@ -74,6 +77,14 @@ struct SaveData
 
 };
 
+// SaveCacheStats counts load() calls served from memory (hits) and from disk (misses).
+
+struct SaveCacheStats
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+};
+
 // SaveSystem encapsulates related behavior and state.
 
 class SaveSystem
@@ -104,30 +115,95 @@ public:
     static void setBattleTroopLevels(const std::unordered_map<int, int>& levels);
     static const std::unordered_map<int, int>& getBattleTroopLevels();
 
+    // Slots live in shard directories (saves/sNNN/) of kSlotsPerShard slots each,
+    // every shard with its own index page.
+    static constexpr int kMaxSlots = 10000;
+    static constexpr int kSlotsPerShard = 100;
+
     // Returns the SaveDir.
 
     static std::string getSaveDir();
-    // Returns the SavePath.
+    // Returns the SavePath (binary .sav file).
     static std::string getSavePath(int slot);
-    // TODO: Add a brief description.
+    // Returns the path of the slot's legacy JSON file (migrated on first load).
+    static std::string getJsonPath(int slot);
+    // Returns the path of the slot's previous snapshot, loaded if the current one is
+    // damaged.
+    static std::string getBackupPath(int slot);
+    // Returns the path of the slot's journal of changes since its last snapshot.
+    static std::string getJournalPath(int slot);
+    // Returns whether the slot holds a save. Answered from memory (slot index).
     static bool exists(int slot);
-    // TODO: Add a brief description.
-    static std::vector<SaveMeta> listAllSlots();
-
-    // Loads data from storage.
+    // The slot index is held in memory, sorted by slot, and kept up to date by
+    // save() and remove(); none of these open a save file. It is read from the
+    // per-shard index pages on first use, and a missing or damaged page is rebuilt
+    // from its shard's slots.
+
+    // Returns the number of slots holding a save, not counting excludeSlot.
+    static int countSlots(int excludeSlot = -1);
+    // Returns up to count saved slots in ascending slot order, skipping the first
+    // offset of them and excludeSlot.
+    static std::vector<SaveMeta> listSlots(int offset, int count, int excludeSlot = -1);
+    // Returns the index entry for slot (exists is false for an empty slot).
+    static SaveMeta getSlotMeta(int slot);
+    // Returns the lowest empty slot, or -1 if all kMaxSlots are taken.
+    static int findFreeSlot();
+
+    // Loads data from storage: the snapshot with its journal replayed on top. A slot
+    // that only has a legacy JSON file is converted to the binary format on the way.
+    // A snapshot that is torn or fails its checksum is replaced by the backup.
+    // Only the first load of a slot reads files; after that, and after any save(),
+    // the slot is copied from memory (up to a handful of slots are kept).
 
     static bool load(int slot, SaveData& outData);
-    // Saves data to storage.
+    // Saves data to storage (binary format). Files are replaced atomically.
     static bool save(const SaveData& data);
+    // Hands a snapshot to the background SaveWorker and returns immediately. Only
+    // what changed since the previous save is appended to the slot's journal; the
+    // journal is folded into a fresh snapshot once it outgrows the snapshot.
+    static bool saveAsync(SaveData&& data);
+    // Returns whether a background write of slot failed since the last call. The
+    // slot's next save is then a full snapshot; the caller should mark its state
+    // dirty so that save happens.
+    static bool takeWriteFailure(int slot);
+    // Writes a slot as JSON to path (for debugging and sharing).
+    static bool exportJson(int slot, const std::string& path);
+    // Replaces a slot with the JSON save at path.
+    static bool importJson(int slot, const std::string& path);
     // Removes an item.
     static bool remove(int slot);
+    // Drops the in-memory copy of slot (never the current slot). Only a handful of
+    // slots are cached at a time anyway; this lets scenes free a village they are
+    // done with, like the defender after a battle.
+    static void releaseCache(int slot);
+    // Returns the load() cache counters since start-up or the last reset.
+    static SaveCacheStats getCacheStats();
+    static void resetCacheStats();
     // TODO: Add a brief description.
     static SaveData makeDefault(int slot, const std::string& name);
 
 private:
-    static constexpr int kMaxSlots = 20;
+    static bool writeBinary(const SaveData& data, int64_t updatedAt, int64_t lastRealTime);
+    static bool migrateJson(int slot, SaveData& outData);
+    static uint64_t journalGeneration(int slot);
+
+    static std::string getShardDir(int shard);
+    static std::string getSlotPath(int slot, const char* ext);
+    static std::string getIndexPath(int shard);
+    static void ensureShardDir(int slot);
+    static SaveMeta makeMeta(const SaveData& data, int64_t updatedAt);
+    static void ensureIndex();
+    static void rebuildIndexPage(int shard);
+    static void trimCache(int keepSlot);
+    static void migrateLegacyLayout();
+    static void setIndexEntry(const SaveMeta& meta);
+    static bool writeIndexPage(int shard, bool async);
+
     static int s_currentSlot;
     static int s_battleTargetSlot;
     static std::unordered_map<int, int> s_battleReadyTroops;
     static std::unordered_map<int, int> s_battleTroopLevels;
+    static std::unordered_map<int, SaveMeta> s_index;   // saved slots only
+    static std::vector<int> s_order;                     // their slot numbers, ascending
+    static bool s_indexLoaded;
 };
\ No newline at end of file
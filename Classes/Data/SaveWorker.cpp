@@ -0,0 +1,309 @@
+// File: SaveWorker.cpp
+// Brief: Implements the SaveWorker component.
+#include "Data/SaveWorker.h"
+#include "Data/SaveCodec.h"
+#include "cocos2d.h"
+
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// PendingSlot is the queued work for one slot, applied in this order: the snapshot
+// (which also drops the slot's old journal), then the journal bytes.
+struct PendingSlot {
+    bool hasSnapshot = false;
+    SaveData data;
+    int64_t updatedAt = 0;
+    uint64_t generation = 0;
+    std::string path;
+    std::string backupPath;
+
+    std::vector<uint8_t> journal;
+    bool truncateJournal = false;   // journal starts with a fresh header
+    std::string journalPath;
+};
+
+// WorkerState holds the queue and the thread. Everything but the thread handle is
+// guarded by mutex.
+struct WorkerState {
+    std::mutex mutex;
+    std::condition_variable wake;   // signalled when work is queued or on stop
+    std::condition_variable idle;   // signalled when a batch is on disk
+    std::unordered_map<int, PendingSlot> saves;   // coalesced work per slot
+    std::unordered_map<std::string, std::vector<SaveMeta>> indexPages;   // by path
+    std::vector<int> failedSlots;   // drained by takeFailedSlots
+    bool busy = false;
+    bool stop = false;
+    std::thread thread;
+
+    ~WorkerState()
+    {
+        if (thread.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stop = true;
+            }
+            wake.notify_one();
+            thread.join();
+        }
+    }
+};
+
+WorkerState s_worker;
+
+#ifdef _WIN32
+std::wstring widen(const std::string& s)
+{
+    int n = MultiByteToWideChar(CP_UTF8, 0, s.c_str(), -1, nullptr, 0);
+    if (n <= 0) return std::wstring();
+    std::wstring w((size_t)n, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, s.c_str(), -1, &w[0], n);
+    w.resize((size_t)n - 1);
+    return w;
+}
+#endif
+
+void removeFile(const std::string& path)
+{
+#ifdef _WIN32
+    _wremove(widen(path).c_str());
+#else
+    std::remove(path.c_str());
+#endif
+}
+
+// Flushes f to the device and closes it. Returns false if any step failed.
+bool syncAndClose(std::FILE* f, bool ok)
+{
+    ok = (std::fflush(f) == 0) && ok;
+#ifdef _WIN32
+    ok = ok && _commit(_fileno(f)) == 0;
+#else
+    ok = ok && fsync(fileno(f)) == 0;
+#endif
+    return (std::fclose(f) == 0) && ok;
+}
+
+void workerLoop()
+{
+    std::unordered_map<int, PendingSlot> saves;
+    std::unordered_map<std::string, std::vector<SaveMeta>> indexPages;
+    std::vector<uint8_t> bytes;   // reused across batches
+    std::vector<int> failed;
+
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(s_worker.mutex);
+            s_worker.wake.wait(lock, [] {
+                return s_worker.stop || !s_worker.saves.empty() || !s_worker.indexPages.empty();
+            });
+            if (s_worker.saves.empty() && s_worker.indexPages.empty()) break;   // stop requested
+
+            saves.swap(s_worker.saves);
+            indexPages.swap(s_worker.indexPages);
+            s_worker.busy = true;
+        }
+
+        for (auto& kv : saves)
+        {
+            const PendingSlot& job = kv.second;
+            if (job.hasSnapshot)
+            {
+                SaveCodec::encodeBinary(job.data, job.updatedAt, job.updatedAt, job.generation, bytes);
+                if (!SaveWorker::writeAtomic(job.path, bytes.data(), bytes.size(), job.backupPath))
+                {
+                    // The journal on disk still belongs to the previous snapshot, and the
+                    // bytes queued after this one would be stamped for the lost one.
+                    CCLOG("[SaveWorker] Failed to write %s", job.path.c_str());
+                    failed.push_back(kv.first);
+                    continue;
+                }
+                removeFile(job.journalPath);
+            }
+            if (!job.journal.empty()
+                && !SaveWorker::appendDurable(job.journalPath, job.journal.data(), job.journal.size(), job.truncateJournal))
+            {
+                CCLOG("[SaveWorker] Failed to append %s", job.journalPath.c_str());
+                failed.push_back(kv.first);
+            }
+        }
+        saves.clear();
+
+        for (const auto& page : indexPages)
+        {
+            SaveCodec::encodeIndex(page.second, bytes);
+            if (!SaveWorker::writeAtomic(page.first, bytes.data(), bytes.size()))
+                CCLOG("[SaveWorker] Failed to write %s", page.first.c_str());
+        }
+        indexPages.clear();
+
+        {
+            std::lock_guard<std::mutex> lock(s_worker.mutex);
+            s_worker.failedSlots.insert(s_worker.failedSlots.end(), failed.begin(), failed.end());
+            s_worker.busy = false;
+        }
+        failed.clear();
+        s_worker.idle.notify_all();
+    }
+}
+
+void ensureThread()
+{
+    if (s_worker.thread.joinable()) return;
+    s_worker.stop = false;
+    s_worker.thread = std::thread(workerLoop);
+}
+
+
+}  // namespace
+
+void SaveWorker::submit(SaveData&& data, int64_t updatedAt, uint64_t generation,
+    const std::string& path, const std::string& backupPath, const std::string& journalPath)
+{
+    {
+        std::lock_guard<std::mutex> lock(s_worker.mutex);
+        PendingSlot& job = s_worker.saves[data.slot];
+        job.hasSnapshot = true;
+        job.data = std::move(data);
+        job.updatedAt = updatedAt;
+        job.generation = generation;
+        job.path = path;
+        job.backupPath = backupPath;
+        // The snapshot supersedes any journal bytes queued before it.
+        job.journal.clear();
+        job.truncateJournal = false;
+        job.journalPath = journalPath;
+        ensureThread();
+    }
+    s_worker.wake.notify_one();
+}
+
+void SaveWorker::append(int slot, const std::vector<uint8_t>& bytes, bool truncate,
+    const std::string& journalPath)
+{
+    {
+        std::lock_guard<std::mutex> lock(s_worker.mutex);
+        PendingSlot& job = s_worker.saves[slot];
+        if (truncate)
+        {
+            job.journal.clear();
+            job.truncateJournal = true;
+        }
+        job.journal.insert(job.journal.end(), bytes.begin(), bytes.end());
+        job.journalPath = journalPath;
+        ensureThread();
+    }
+    s_worker.wake.notify_one();
+}
+
+void SaveWorker::submitIndex(const std::vector<SaveMeta>& metas, const std::string& path)
+{
+    {
+        std::lock_guard<std::mutex> lock(s_worker.mutex);
+        s_worker.indexPages[path] = metas;
+        ensureThread();
+    }
+    s_worker.wake.notify_one();
+}
+
+void SaveWorker::flush()
+{
+    std::unique_lock<std::mutex> lock(s_worker.mutex);
+    s_worker.idle.wait(lock, [] {
+        return s_worker.saves.empty() && s_worker.indexPages.empty() && !s_worker.busy;
+    });
+}
+
+void SaveWorker::shutdown()
+{
+    flush();
+    if (!s_worker.thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(s_worker.mutex);
+        s_worker.stop = true;
+    }
+    s_worker.wake.notify_one();
+    s_worker.thread.join();
+}
+
+void SaveWorker::takeFailedSlots(std::vector<int>& out)
+{
+    out.clear();
+    std::lock_guard<std::mutex> lock(s_worker.mutex);
+    out.swap(s_worker.failedSlots);
+}
+
+std::FILE* SaveWorker::openFile(const std::string& path, const char* mode)
+{
+#ifdef _WIN32
+    return _wfopen(widen(path).c_str(), widen(mode).c_str());
+#else
+    return std::fopen(path.c_str(), mode);
+#endif
+}
+
+bool SaveWorker::writeAtomic(const std::string& path, const uint8_t* bytes, size_t size,
+    const std::string& backupPath)
+{
+    const std::string tmp = path + ".tmp";
+    std::FILE* f = openFile(tmp, "wb");
+    if (!f) return false;
+
+    const bool written = size == 0 || std::fwrite(bytes, 1, size, f) == size;
+    if (!syncAndClose(f, written))
+    {
+        removeFile(tmp);
+        return false;
+    }
+
+#ifdef _WIN32
+    // ReplaceFileW swaps in the new file and keeps the old one as the backup in one
+    // call; it needs an existing target, so the first write is a plain move.
+    if (!backupPath.empty()
+        && ReplaceFileW(widen(path).c_str(), widen(tmp).c_str(), widen(backupPath).c_str(),
+            REPLACEFILE_IGNORE_MERGE_ERRORS, nullptr, nullptr))
+        return true;
+    return MoveFileExW(widen(tmp).c_str(), widen(path).c_str(),
+        MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    // Between the two renames only the backup exists; SaveSystem::load falls back
+    // to it, so a crash there loses nothing that was durable.
+    if (!backupPath.empty() && access(path.c_str(), F_OK) == 0)
+        std::rename(path.c_str(), backupPath.c_str());
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) return false;
+
+    // Make the renames themselves durable.
+    const std::string::size_type slash = path.find_last_of('/');
+    const std::string dir = (slash == std::string::npos) ? std::string(".") : path.substr(0, slash + 1);
+    int fd = open(dir.c_str(), O_RDONLY);
+    if (fd >= 0)
+    {
+        fsync(fd);
+        close(fd);
+    }
+    return true;
+#endif
+}
+
+bool SaveWorker::appendDurable(const std::string& path, const uint8_t* bytes, size_t size,
+    bool truncate)
+{
+    std::FILE* f = openFile(path, truncate ? "wb" : "ab");
+    if (!f) return false;
+    const bool written = size == 0 || std::fwrite(bytes, 1, size, f) == size;
+    return syncAndClose(f, written);
+}
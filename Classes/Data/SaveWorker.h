@@ -0,0 +1,65 @@
+// File: SaveWorker.h
+// Brief: Declares the SaveWorker component.
+#pragma once
+
+#include "Data/SaveSystem.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// SaveWorker writes save snapshots on a background thread.
+//
+// The caller hands over either a full SaveData snapshot (moved, not copied) or
+// journal bytes to append, and returns immediately; encoding and file I/O happen
+// off the frame thread. Work is coalesced per slot: a newer snapshot replaces a
+// queued one together with the journal bytes queued before it, and appends queued
+// back to back are written in one go. Snapshots go through writeAtomic, so a crash
+// mid-write leaves the previous version of the file intact; a torn journal append is
+// cut off by the record checksums on replay. Slots whose snapshot or journal write
+// failed are reported through takeFailedSlots so SaveSystem can rewrite them.
+//
+// All methods are main-thread only. SaveSystem flushes the worker before it reads
+// or writes slots synchronously, so callers never observe a stale file.
+
+class SaveWorker {
+public:
+    // Queues a slot snapshot to be written to path, stamped with updatedAt and
+    // generation; the snapshot it replaces is kept at backupPath. Once it is on disk
+    // the slot's journal at journalPath is deleted.
+    static void submit(SaveData&& data, int64_t updatedAt, uint64_t generation,
+        const std::string& path, const std::string& backupPath, const std::string& journalPath);
+
+    // Queues bytes to be appended to the slot's journal. With truncate the journal is
+    // rewritten from these bytes (they must start with a journal header).
+    static void append(int slot, const std::vector<uint8_t>& bytes, bool truncate,
+        const std::string& journalPath);
+
+    // Queues an index page to be written to path (replaces one queued for the same
+    // path).
+    static void submitIndex(const std::vector<SaveMeta>& metas, const std::string& path);
+
+    // Blocks until everything queued so far is on disk. Cheap when idle.
+    static void flush();
+
+    // Flushes and stops the thread (restarted by the next submit).
+    static void shutdown();
+
+    // Moves the slots whose snapshot or journal write failed since the last call
+    // into out (cleared first).
+    static void takeFailedSlots(std::vector<int>& out);
+
+    // std::fopen for a UTF-8 path; on Windows it goes through _wfopen so paths
+    // outside the ANSI code page open too.
+    static std::FILE* openFile(const std::string& path, const char* mode);
+
+    // Writes bytes to path.tmp, syncs it to disk and renames it over path. With a
+    // backupPath, the file being replaced is moved there first instead of dropped.
+    static bool writeAtomic(const std::string& path, const uint8_t* bytes, size_t size,
+        const std::string& backupPath = std::string());
+
+    // Appends bytes to path (or replaces its content with truncate) and syncs it.
+    static bool appendDurable(const std::string& path, const uint8_t* bytes, size_t size,
+        bool truncate);
+};
@@ -2,6 +2,7 @@
 // Brief: Declares the Building component.
 #pragma once
 #include "cocos2d.h"
+#include <algorithm>
 #include <string>
 
 // Building encapsulates related behavior and state.
@@ -18,6 +19,8 @@ public:
     int capacity = 0;
     float stored = 0.f;
     int chunkMinutes = 0;
+    float storedAtCollect = 0.f;     // stored at lastCollectTime
+    double lastCollectTime = 0.0;    // production clock, see storedAt()
     std::string image;
 
     
@@ -39,6 +42,33 @@ public:
         return buildState == STATE_NORMAL || buildTotalSec <= 0.0f || buildRemainSec <= 0.0f;
     }
 
+    // Production is kept in closed form instead of being ticked every frame: the
+    // amount at clock time t (seconds, already time-scaled) follows from the amount
+    // and time of the last restartProduction(). Callers resync before anything that
+    // changes the rate or the functional state and restart right after it.
+
+    // Amount a producer holds after elapsedSec, starting from storedAtStart.
+    static float storedAfter(float storedAtStart, int ratePerHour, int capacity, double elapsedSec) {
+        if (ratePerHour <= 0 || elapsedSec <= 0.0) return storedAtStart;
+        const double add = (double)ratePerHour * (elapsedSec / 3600.0);
+        return (float)std::min((double)capacity, (double)storedAtStart + add);
+    }
+
+    // Returns the stored amount at clock time now. Paused while building/upgrading.
+    float storedAt(double now) const {
+        if (!isFunctional()) return stored;
+        return storedAfter(storedAtCollect, ratePerHour, capacity, now - lastCollectTime);
+    }
+
+    // Brings stored up to date with clock time now.
+    void syncProduction(double now) { stored = storedAt(now); }
+
+    // Starts a new production interval at now from the current stored amount.
+    void restartProduction(double now) {
+        storedAtCollect = stored;
+        lastCollectTime = now;
+    }
+
     virtual cocos2d::Sprite* createSprite() const {
         auto s = cocos2d::Sprite::create(image);
         if (!s) {
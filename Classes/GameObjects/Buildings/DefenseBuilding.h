@@ -53,8 +53,8 @@ public:
  * Cannon building.
  *
  * The cannon is a defense that shoots the nearest enemy unit within range.
- * In battle, the cannon barrel sprite is rotated by swapping textures based on
- * the current target direction (see CombatSystem::tryDefenseShoot).
+ * In battle, the cannon barrel sprite is rotated by swapping preloaded frames based on
+ * the current target direction (see CombatSystem::tryDefenseShoot and DirectionalFrames).
  */
 class Cannon : public Building {
 public:
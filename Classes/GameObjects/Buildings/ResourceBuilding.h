@@ -22,24 +22,21 @@ public:
         hpMax = st.hp;
         if (hp > hpMax) hp = hpMax;
     }
-    void updateProduction(float dt, float timeScale) {
-        float add = ratePerHour * (timeScale * dt / 3600.0f);
-        stored = std::min((float)capacity, stored + add);
-    }
-    bool canCollect() const {
+    bool canCollect(double now) const {
         
         
         const int cap = ResourceManager::getElixirCap();
         const int cur = ResourceManager::getElixir();
         const int deliverMax = std::max(0, cap - cur);
-        const int deliverable = std::min(deliverMax, (int)std::floor(stored));
+        const int deliverable = std::min(deliverMax, (int)std::floor(storedAt(now)));
 
         
         const int threshold = std::max(1, (int)std::ceil((float)cap * 0.01f));
         return deliverable >= threshold;
     }
 
-    int collect(bool ignoreThreshold = false) {
+    int collect(double now, bool ignoreThreshold = false) {
+        syncProduction(now);
         const int cap = ResourceManager::getElixirCap();
         const int cur = ResourceManager::getElixir();
         const int deliverMax = std::max(0, cap - cur);
@@ -51,12 +48,13 @@ public:
         if (deliver > 0) {
             ResourceManager::addElixir(deliver);
             stored -= deliver;
+            restartProduction(now);
         }
         return deliver;
     }
 
-    void manageCollectPrompt(cocos2d::Node* parent, cocos2d::Sprite* sprite) {
-        bool show = canCollect();
+    void manageCollectPrompt(cocos2d::Node* parent, cocos2d::Sprite* sprite, double now) {
+        bool show = canCollect(now);
         if (show) {
             if (!promptLabel) {
                 promptLabel = cocos2d::Label::createWithSystemFont("Collect", "Arial", 16);
@@ -110,23 +108,20 @@ public:
         hpMax = st.hp;
         if (hp > hpMax) hp = hpMax;
     }
-    void updateProduction(float dt, float timeScale) {
-        float add = ratePerHour * (timeScale * dt / 3600.0f);
-        stored = std::min((float)capacity, stored + add);
-    }
-        bool canCollect() const {
+        bool canCollect(double now) const {
         
         
         const int cap = ResourceManager::getGoldCap();
         const int cur = ResourceManager::getGold();
         const int deliverMax = std::max(0, cap - cur);
-        const int deliverable = std::min(deliverMax, (int)std::floor(stored));
+        const int deliverable = std::min(deliverMax, (int)std::floor(storedAt(now)));
 
         
         const int threshold = std::max(1, (int)std::ceil((float)cap * 0.01f));
         return deliverable >= threshold;
     }
-        int collect(bool ignoreThreshold = false) {
+        int collect(double now, bool ignoreThreshold = false) {
+        syncProduction(now);
         const int cap = ResourceManager::getGoldCap();
         const int cur = ResourceManager::getGold();
         const int deliverMax = std::max(0, cap - cur);
@@ -138,11 +133,12 @@ public:
         if (deliver > 0) {
             ResourceManager::addGold(deliver);
             stored -= deliver;
+            restartProduction(now);
         }
 	        return deliver;
 	    }
-    void manageCollectPrompt(cocos2d::Node* parent, cocos2d::Sprite* sprite) {
-        bool show = canCollect();
+    void manageCollectPrompt(cocos2d::Node* parent, cocos2d::Sprite* sprite, double now) {
+        bool show = canCollect(now);
         if (show) {
             if (!promptLabel) {
                 promptLabel = cocos2d::Label::createWithSystemFont("Collect", "Arial", 16);
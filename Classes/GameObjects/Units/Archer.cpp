@@ -1,6 +1,7 @@
 // File: Archer.cpp
 // Brief: Implements the Archer component.
 #include "GameObjects/Units/Archer.h"
+#include "Patterns/DamageMatrix.h"
 
 #include <algorithm>
 
@@ -23,14 +24,13 @@ void Archer::applyLevel(int lvl)
 {
     
     static const int kHp[5] = { 22, 26, 29, 33, 40 };
-    static const int kDmg[5] = { 8, 10, 13, 16, 20 };
 
     lvl = std::max(1, std::min(5, lvl));
     level = lvl;
 
     hpMax = kHp[lvl - 1];
     hp = hpMax;
-    damage = kDmg[lvl - 1];
+    damage = unitDamagePerAttack(unitId, lvl);
     attackInterval = 1.0f;
 
     
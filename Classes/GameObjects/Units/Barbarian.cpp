@@ -1,6 +1,7 @@
 // File: Barbarian.cpp
 // Brief: Implements the Barbarian component.
 #include "GameObjects/Units/Barbarian.h"
+#include "Patterns/DamageMatrix.h"
 
 #include <algorithm>
 
@@ -26,14 +27,13 @@ void Barbarian::applyLevel(int lvl)
     
     
     static const int kHp[5] = { 45, 54, 65, 85, 105 };
-    static const int kDmg[5] = { 9, 12, 15, 18, 23 };
 
     lvl = std::max(1, std::min(5, lvl));
     level = lvl;
 
     hpMax = kHp[lvl - 1];
     hp = hpMax;
-    damage = kDmg[lvl - 1];
+    damage = unitDamagePerAttack(unitId, lvl);
     attackInterval = 1.0f;
 
     
@@ -1,6 +1,7 @@
 // File: Giant.cpp
 // Brief: Implements the Giant component.
 #include "GameObjects/Units/Giant.h"
+#include "Patterns/DamageMatrix.h"
 
 #include <algorithm>
 
@@ -20,14 +21,13 @@ void Giant::applyLevel(int lvl)
     
     
     static const int kHp[5] = { 400, 500, 600, 700, 900 };
-    static const int kDmg[5] = { 24, 30, 40, 48, 62 };
 
     lvl = std::max(1, std::min(5, lvl));
     level = lvl;
 
     hpMax = kHp[lvl - 1];
     hp = hpMax;
-    damage = kDmg[lvl - 1];
+    damage = unitDamagePerAttack(unitId, lvl);
 
     
     attackInterval = 2.0f;
@@ -0,0 +1,134 @@
+// File: UnitTraits.h
+// Brief: Declares the UnitTraits component.
+#pragma once
+
+// Unit type ids as used by UnitFactory, saves and the troop bar.
+enum UnitTypeId {
+    UNIT_BARBARIAN = 1,
+    UNIT_ARCHER = 2,
+    UNIT_GIANT = 3,
+    UNIT_BOMBER = 4,
+};
+
+static const int UNIT_TYPE_COUNT = 4;
+
+// What a unit walks to first.
+enum class UnitTargetPreference {
+    Nearest,    // nearest non-wall building
+    Defenses,   // nearest defense while any is alive, then nearest
+    Walls,      // nearest wall, then nearest non-wall
+};
+
+// How a unit deals with walls in its way.
+enum class UnitWallHandling {
+    None,       // never targets walls (waits for a path)
+    Attack,     // hits a blocking wall until it breaks
+    Explode,    // walks to a wall and blows up
+};
+
+// UnitTraits is the compile-time behavior table of one unit type.
+//
+// AISystem instantiates its per-unit update once per type from these traits, so
+// per-type decisions are resolved at compile time instead of comparing unitId
+// inside the loop. Code that only has a runtime id reads the same data through
+// getUnitTraitsRow().
+
+template <int Id>
+struct UnitTraits;
+
+template <>
+struct UnitTraits<UNIT_BARBARIAN> {
+    static constexpr int id = UNIT_BARBARIAN;
+    static constexpr UnitTargetPreference target = UnitTargetPreference::Nearest;
+    static constexpr UnitWallHandling walls = UnitWallHandling::Attack;
+    static constexpr int approachRange = 1;
+    static constexpr bool ranged = false;
+    static constexpr bool blockedCentersOnly = false;
+    static constexpr const char* deathSfx = "barbarian_death";
+    static constexpr const char* hitSfx = "barbarian_hit_stuff";
+    static constexpr const char* deploySfx = "music/troop_housing_placing_06.ogg";
+};
+
+template <>
+struct UnitTraits<UNIT_ARCHER> {
+    static constexpr int id = UNIT_ARCHER;
+    static constexpr UnitTargetPreference target = UnitTargetPreference::Nearest;
+    static constexpr UnitWallHandling walls = UnitWallHandling::None;
+    static constexpr int approachRange = 3;
+    static constexpr bool ranged = true;
+    static constexpr bool blockedCentersOnly = false;
+    static constexpr const char* deathSfx = "archer_death";
+    static constexpr const char* hitSfx = "arrow_hit";
+    static constexpr const char* deploySfx = "music/archer_deploy_09.ogg";
+};
+
+template <>
+struct UnitTraits<UNIT_GIANT> {
+    static constexpr int id = UNIT_GIANT;
+    static constexpr UnitTargetPreference target = UnitTargetPreference::Defenses;
+    static constexpr UnitWallHandling walls = UnitWallHandling::Attack;
+    static constexpr int approachRange = 1;
+    static constexpr bool ranged = false;
+    // Giants only treat building centers as obstacles when pathing.
+    static constexpr bool blockedCentersOnly = true;
+    static constexpr const char* deathSfx = "giant_death";
+    static constexpr const char* hitSfx = "giant_attack";
+    static constexpr const char* deploySfx = "music/giant_deploy_04v3.ogg";
+};
+
+template <>
+struct UnitTraits<UNIT_BOMBER> {
+    static constexpr int id = UNIT_BOMBER;
+    static constexpr UnitTargetPreference target = UnitTargetPreference::Walls;
+    static constexpr UnitWallHandling walls = UnitWallHandling::Explode;
+    static constexpr int approachRange = 1;
+    static constexpr bool ranged = false;
+    static constexpr bool blockedCentersOnly = false;
+    static constexpr const char* deathSfx = "wall_breaker_death";
+    static constexpr const char* hitSfx = "wall_breaker_attack";
+    static constexpr const char* deploySfx = "music/troop_housing_placing_08.ogg";
+};
+
+// Calls fn(UnitTraits<Id>{}) for every unit type, in id order.
+template <typename Fn>
+inline void forEachUnitType(Fn&& fn)
+{
+    fn(UnitTraits<UNIT_BARBARIAN>{});
+    fn(UnitTraits<UNIT_ARCHER>{});
+    fn(UnitTraits<UNIT_GIANT>{});
+    fn(UnitTraits<UNIT_BOMBER>{});
+}
+
+// UnitTraitsRow is the runtime copy of UnitTraits<Id> for code paths that only know the id.
+struct UnitTraitsRow {
+    int id;
+    UnitTargetPreference target;
+    UnitWallHandling walls;
+    int approachRange;
+    bool ranged;
+    bool blockedCentersOnly;
+    const char* deathSfx;
+    const char* hitSfx;
+    const char* deploySfx;
+};
+
+template <typename T>
+constexpr UnitTraitsRow makeUnitTraitsRow()
+{
+    return { T::id, T::target, T::walls, T::approachRange, T::ranged,
+             T::blockedCentersOnly, T::deathSfx, T::hitSfx, T::deploySfx };
+}
+
+// Returns the traits row of a unit id; unknown ids get barbarian behavior.
+inline const UnitTraitsRow& getUnitTraitsRow(int unitId)
+{
+    static const UnitTraitsRow kRows[UNIT_TYPE_COUNT + 1] = {
+        makeUnitTraitsRow<UnitTraits<UNIT_BARBARIAN>>(),
+        makeUnitTraitsRow<UnitTraits<UNIT_BARBARIAN>>(),
+        makeUnitTraitsRow<UnitTraits<UNIT_ARCHER>>(),
+        makeUnitTraitsRow<UnitTraits<UNIT_GIANT>>(),
+        makeUnitTraitsRow<UnitTraits<UNIT_BOMBER>>(),
+    };
+    if (unitId < 1 || unitId > UNIT_TYPE_COUNT) return kRows[0];
+    return kRows[unitId];
+}
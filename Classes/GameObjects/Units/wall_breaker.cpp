@@ -1,6 +1,7 @@
 // File: wall_breaker.cpp
 // Brief: Implements the wall_breaker component.
 #include "GameObjects/Units/wall_breaker.h"
+#include "Patterns/DamageMatrix.h"
 
 #include <algorithm>
 
@@ -21,7 +22,6 @@ void WallBreaker::applyLevel(int lvl)
     
     
     static const int kHp[5] = { 20, 24, 29, 35, 53 };
-    static const int kDmg[5] = { 10, 20, 25, 30, 43 };
     static const int kDeath[5] = { 6, 9, 13, 16, 23 };
 
     lvl = std::max(1, std::min(5, lvl));
@@ -29,7 +29,7 @@ void WallBreaker::applyLevel(int lvl)
 
     hpMax = kHp[lvl - 1];
     hp = hpMax;
-    damage = kDmg[lvl - 1];
+    damage = unitDamagePerAttack(unitId, lvl);
     deathDamage = kDeath[lvl - 1];
 
     
@@ -41,6 +41,5 @@ void WallBreaker::applyLevel(int lvl)
     costElixir = 0;
     trainingTimeSec = 0;
 
-    wallDamageMultiplier = 40;
     damageRadiusTiles = 2.0f;
 }
@@ -19,7 +19,6 @@
 class WallBreaker : public UnitBase {
 public:
     
-    int wallDamageMultiplier = 40;
     float damageRadiusTiles = 2.0f;
     int deathDamage = 6; 
 
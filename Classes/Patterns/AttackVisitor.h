@@ -6,11 +6,24 @@
 #include "GameObjects/Buildings/TownHall.h"
 #include "GameObjects/Buildings/ResourceBuilding.h"
 #include "GameObjects/Buildings/TroopBuilding.h"
+#include "Patterns/DamageMatrix.h"
 
 // AttackVisitor encapsulates related behavior and state.
 
 class AttackVisitor {
 public:
-    // TODO: Add a brief description.
-    static int computeDamage(const UnitBase& attacker, const Building& target);
+    // Returns the damage of one hit on a building of the given BuildingCategory,
+    // read from the compile-time damage matrix (no virtual calls or casts).
+    static int computeDamage(const UnitBase& attacker, int targetCategory)
+    {
+        const unsigned u = (unsigned)attacker.unitId;
+        const unsigned c = (unsigned)targetCategory;
+        const unsigned l = (unsigned)attacker.level;
+        if (u - 1u >= (unsigned)UNIT_TYPE_COUNT || c >= (unsigned)BUILDING_CATEGORY_COUNT
+            || l - 1u >= (unsigned)UNIT_MAX_LEVEL)
+        {
+            return attacker.damage < 1 ? 1 : attacker.damage;
+        }
+        return kDamageMatrix.value[u][c][l];
+    }
 };
@@ -0,0 +1,84 @@
+// File: DamageMatrix.h
+// Brief: Declares the DamageMatrix component.
+#pragma once
+
+#include "GameObjects/Units/UnitTraits.h"
+
+// Building categories used for damage bonuses (PT = preferred target in unit.json).
+enum BuildingCategory {
+    BUILDING_CATEGORY_OTHER = 0,     // barracks, army camps, ...
+    BUILDING_CATEGORY_RESOURCE,      // mines, collectors, storages
+    BUILDING_CATEGORY_DEFENSE,       // arrow tower, cannon
+    BUILDING_CATEGORY_WALL,
+    BUILDING_CATEGORY_TOWN_HALL,
+    BUILDING_CATEGORY_COUNT
+};
+
+// Returns the category of a building id (see BuildingFactory).
+constexpr int buildingCategoryOf(int buildingId)
+{
+    return (buildingId == 1 || buildingId == 2) ? BUILDING_CATEGORY_DEFENSE
+        : (buildingId >= 3 && buildingId <= 6) ? BUILDING_CATEGORY_RESOURCE
+        : (buildingId == 9) ? BUILDING_CATEGORY_TOWN_HALL
+        : (buildingId == 10) ? BUILDING_CATEGORY_WALL
+        : BUILDING_CATEGORY_OTHER;
+}
+
+static const int UNIT_MAX_LEVEL = 5;
+
+// Damage per attack (DPA) by unit id and level; index 0 is unused on both axes.
+// The unit classes read their damage stat from here.
+static constexpr int kUnitDamagePerAttack[UNIT_TYPE_COUNT + 1][UNIT_MAX_LEVEL + 1] = {
+    { 0, 0, 0, 0, 0, 0 },
+    { 0, 9, 12, 15, 18, 23 },       // barbarian
+    { 0, 8, 10, 13, 16, 20 },       // archer
+    { 0, 24, 30, 40, 48, 62 },      // giant
+    { 0, 10, 20, 25, 30, 43 },      // wall breaker
+};
+
+// Damage multiplier in percent by unit id and building category.
+static constexpr int kDamagePercent[UNIT_TYPE_COUNT + 1][BUILDING_CATEGORY_COUNT] = {
+    //  other  resource  defense  wall  town hall
+    { 100, 100, 100, 100, 100 },
+    { 100, 100, 100, 100, 100 },    // barbarian
+    { 100, 100, 100, 100, 100 },    // archer
+    { 100, 100, 200, 100, 100 },    // giant: double damage on defenses
+    { 100, 100, 100, 4000, 100 },   // wall breaker: x40 on walls
+};
+
+// DamageMatrixTable holds the final damage per hit for every (unit, category, level).
+struct DamageMatrixTable {
+    int value[UNIT_TYPE_COUNT + 1][BUILDING_CATEGORY_COUNT][UNIT_MAX_LEVEL + 1];
+};
+
+// Builds the matrix from the DPA and percent tables; evaluated at compile time.
+constexpr DamageMatrixTable makeDamageMatrix()
+{
+    DamageMatrixTable t{};
+    for (int u = 0; u <= UNIT_TYPE_COUNT; ++u)
+    {
+        for (int c = 0; c < BUILDING_CATEGORY_COUNT; ++c)
+        {
+            for (int l = 0; l <= UNIT_MAX_LEVEL; ++l)
+            {
+                const int dmg = kUnitDamagePerAttack[u][l] * kDamagePercent[u][c] / 100;
+                t.value[u][c][l] = dmg < 1 ? 1 : dmg;
+            }
+        }
+    }
+    return t;
+}
+
+static constexpr DamageMatrixTable kDamageMatrix = makeDamageMatrix();
+
+static_assert(kDamageMatrix.value[UNIT_GIANT][BUILDING_CATEGORY_DEFENSE][1] == 48, "giant bonus vs defenses");
+static_assert(kDamageMatrix.value[UNIT_BOMBER][BUILDING_CATEGORY_WALL][1] == 400, "wall breaker bonus vs walls");
+
+// Returns the DPA of a unit id and level (clamped to 1..UNIT_MAX_LEVEL), 0 for unknown ids.
+inline int unitDamagePerAttack(int unitId, int level)
+{
+    if (unitId < 1 || unitId > UNIT_TYPE_COUNT) return 0;
+    if (level < 1) level = 1;
+    if (level > UNIT_MAX_LEVEL) level = UNIT_MAX_LEVEL;
+    return kUnitDamagePerAttack[unitId][level];
+}
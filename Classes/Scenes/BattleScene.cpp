@@ -4,11 +4,17 @@
 #include "Scenes/MainScene.h"
 #include "Scenes/LoginScene.h"
 #include "Data/SaveSystem.h"
+#include "Data/SaveWorker.h"
 #include "GameObjects/Buildings/Building.h"
 #include "GameObjects/Buildings/TroopBuilding.h"
+#include "GameObjects/Units/UnitTraits.h"
 #include "Managers/ConfigManager.h"
 #include "Managers/ResourceManager.h"
 #include "Managers/SoundManager.h"
+#include "Systems/CombatLog.h"
+#include "Systems/CombatSystem.h"
+#include "UI/DamageNumberLayer.h"
+#include "UI/HpBarLayer.h"
 
 #include "ui/CocosGUI.h"
 
@@ -186,6 +192,9 @@ _deployAreaReady = true;
     _enemyBuildings.clear();
     _enemyBuildings.reserve(data.buildings.size());
 
+    // Cannons turn by swapping preloaded frames that fit the same 3x3 footprint.
+    CombatSystem::prepareDefenseVisuals(Size(std::max(1.0f, _tileW * 3.0f), std::max(1.0f, _tileH * 3.0f)));
+
     for (int bi = 0; bi < (int)data.buildings.size(); ++bi)
     {
         const auto& bInfo = data.buildings[bi];
@@ -226,11 +235,15 @@ _deployAreaReady = true;
         rt.building = std::move(b);
         rt.sprite = sprite;
         rt.lastHp = rt.building ? rt.building->hp : 0;
+        CombatSystem::initBuildingStats(rt);
 
         _enemyBuildings.push_back(std::move(rt));
         _world->addChild(sprite, 3 + bInfo.r + bInfo.c);
     }
 
+    // Footprints and approach rings never change during a battle; compute them once.
+    _ai.prepareBuildings(_enemyBuildings);
+
 
 
 
@@ -557,6 +570,11 @@ bool BattleScene::init()
     _world = Node::create();
     this->addChild(_world, 0);
 
+    // Projectiles, health bars and floating damage numbers draw above everything else in the world.
+    _ai.projectiles().attach(_world, 997);
+    _world->addChild(HpBarLayer::create(), 998);
+    _world->addChild(DamageNumberLayer::create(), 999);
+
     _background = Sprite::create("backgrounds/village_map.jpg");
     if (_background)
     {
@@ -824,6 +842,7 @@ void BattleScene::startPhase(Phase p, float durationSec)
     }
     else if (p == Phase::Battle) {
         SoundManager::play("music/capital_battle_music.ogg", true, 0.6f);
+        if (CombatLog::isEnabled()) CombatLog::begin(CombatLog::defaultPath());
     }
     else if (p == Phase::End) {
         SoundManager::playSfx("music/capital_battle_end.ogg", 1.0f);
@@ -892,6 +911,15 @@ void BattleScene::checkBattleResult(bool timeUp)
     endBattleAndShowResult(win);
 }
 
+void BattleScene::onExit()
+{
+    // Leaving mid-battle never reaches endBattleAndShowResult.
+    CombatLog::end();
+    // The defender's village is not needed in memory once the battle is over.
+    if (_defenderSlot >= 0) SaveSystem::releaseCache(_defenderSlot);
+    Scene::onExit();
+}
+
 void BattleScene::update(float dt)
 {
     if (_phase == Phase::End) return;
@@ -1008,6 +1036,9 @@ void BattleScene::endBattleAndShowResult(bool win)
     _phase = Phase::End;
     _phaseRemaining = 0.0f;
 
+    // Flush the combat analytics of this battle.
+    CombatLog::end();
+
     
     this->unscheduleUpdate();
     updateBattleHUD();
@@ -1252,7 +1283,11 @@ void BattleScene::openEscMenu()
 
     auto exitLabel = Label::createWithSystemFont("Exit Game", "Arial", 42);
     auto exitItem = MenuItemLabel::create(exitLabel, [](Ref*) {
+        // Let queued saves reach the disk before the process goes away.
+        SaveWorker::shutdown();
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32)
+        // ExitProcess skips onExit and static destructors.
+        CombatLog::end();
         ExitProcess(0);
 #else
         Director::getInstance()->end();
@@ -1875,18 +1910,7 @@ void BattleScene::deploySelectedTroop(const cocos2d::Vec2& glPos)
     _deployedCounts[_selectedTroopType] += 1;
 
     
-    if (_selectedTroopType == 2) {
-        SoundManager::playSfx("music/archer_deploy_09.ogg", 1.0f);
-    }
-    else if (_selectedTroopType == 3) {
-        SoundManager::playSfx("music/giant_deploy_04v3.ogg", 1.0f);
-    }
-    else if (_selectedTroopType == 4) {
-        SoundManager::playSfx("music/troop_housing_placing_08.ogg", 1.0f);
-    }
-    else {
-        SoundManager::playSfx("music/troop_housing_placing_06.ogg", 1.0f);
-    }
+    SoundManager::playSfx(getUnitTraitsRow(_selectedTroopType).deploySfx, 1.0f);
 
     
     if (!_hasDeployedAnyTroop) {
@@ -1955,6 +1979,8 @@ bool BattleScene::spawnUnit(int unitId, const cocos2d::Vec2& worldLocalPos)
     rt.unit = std::move(u);
     rt.sprite = spr;
     rt.targetIndex = -1;
+    CombatSystem::initUnitStats(rt);
+    _ai.assignSquad(rt);
     _units.push_back(std::move(rt));
 
     return true;
@@ -20,6 +20,8 @@ public:
     virtual bool init() override;
     // Updates the object state.
     virtual void update(float dt) override;
+    // Stops combat logging and releases the defender however the battle is left.
+    virtual void onExit() override;
     CREATE_FUNC(BattleScene);
 
 // TODO: Add a brief description.
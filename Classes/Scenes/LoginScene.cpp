@@ -109,6 +109,31 @@ void LoginScene::buildSaveUI()
     header->setPosition(Vec2(panelW / 2, panelH - 50));
     panel->addChild(header);
 
+    // One page of kSavePageSize saves is listed at a time.
+    auto prevLabel = Label::createWithSystemFont("<", "Arial", 40);
+    prevLabel->setColor(Color3B::BLACK);
+    auto prevItem = MenuItemLabel::create(prevLabel, [this](Ref*) {
+        if (_savePage <= 0) return;
+        --_savePage;
+        this->refreshSaveList();
+    });
+    prevItem->setPosition(Vec2(40, panelH - 50));
+    auto nextLabel = Label::createWithSystemFont(">", "Arial", 40);
+    nextLabel->setColor(Color3B::BLACK);
+    auto nextItem = MenuItemLabel::create(nextLabel, [this](Ref*) {
+        ++_savePage;
+        this->refreshSaveList();
+    });
+    nextItem->setPosition(Vec2(180, panelH - 50));
+    auto pageMenu = Menu::create(prevItem, nextItem, nullptr);
+    pageMenu->setPosition(Vec2::ZERO);
+    panel->addChild(pageMenu, 2);
+
+    _savePageLabel = Label::createWithSystemFont("", "Arial", 26);
+    _savePageLabel->setColor(Color3B::BLACK);
+    _savePageLabel->setPosition(Vec2(110, panelH - 50));
+    panel->addChild(_savePageLabel);
+
     
     auto backLabel = Label::createWithSystemFont("Back", "Arial", 36);
     backLabel->setColor(Color3B::BLACK);
@@ -138,13 +163,11 @@ void LoginScene::refreshSaveList()
 {
     if (!_saveScroll || !_saveContent) return;
 
-    auto metasAll = SaveSystem::listAllSlots();
-    std::vector<SaveMeta> metas;
-    metas.reserve(metasAll.size());
-    for (const auto& m : metasAll)
-    {
-        if (m.exists) metas.push_back(m);
-    }
+    const int total = SaveSystem::countSlots();
+    const int pages = std::max(1, (total + kSavePageSize - 1) / kSavePageSize);
+    _savePage = std::min(std::max(_savePage, 0), pages - 1);
+    if (_savePageLabel) _savePageLabel->setString(StringUtils::format("%d/%d", _savePage + 1, pages));
+    std::vector<SaveMeta> metas = SaveSystem::listSlots(_savePage * kSavePageSize, kSavePageSize);
 
     _saveContent->removeAllChildren();
 
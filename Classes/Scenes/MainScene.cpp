@@ -4,6 +4,7 @@
 #include "Scenes/BattleScene.h"
 #include "Scenes/MenuScene.h"
 #include "Data/SaveSystem.h"
+#include "Data/SaveWorker.h"
 #include "Managers/ConfigManager.h"
 #include "Managers/ResourceManager.h"
 #include "Managers/SoundManager.h"
@@ -488,7 +489,11 @@ void MainScene::openEscMenu()
         });
 
     auto exitLabel = Label::createWithSystemFont("Exit Game", "Arial", 42);
-    auto exitItem = MenuItemLabel::create(exitLabel, [](Ref*) {
+    auto exitItem = MenuItemLabel::create(exitLabel, [this](Ref*) {
+        // ExitProcess skips onExit and ~AppDelegate: save now and wait for the
+        // save worker to put everything queued on disk.
+        saveToCurrentSlot(true);
+        SaveWorker::shutdown();
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32)
         ExitProcess(0);
 #else
@@ -882,6 +887,8 @@ void MainScene::updateBuildSystems(float dt)
 
 
             BuildingFactory::applyStats(pb.data.get(), pb.id, pb.data->level, true, false);
+            // Production was paused during the work; resume at the new rate from now.
+            pb.data->restartProduction(_productionClock);
 
 
 
@@ -930,14 +937,8 @@ void MainScene::updateBuildSystems(float dt)
     }
 }
 
-void MainScene::update(float dt)
+void MainScene::refreshCollectPrompts()
 {
-
-    updateBuildSystems(dt);
-
-
-    updateResearchSystems(dt);
-
     for (size_t i = 0; i < _buildings.size(); ++i) {
         auto& pb = _buildings[i];
         if (!pb.data) continue;
@@ -961,18 +962,30 @@ void MainScene::update(float dt)
         }
 
         if (auto ec = dynamic_cast<ElixirCollector*>(pb.data.get())) {
-            float before = ec->stored;
-            ec->updateProduction(dt, _timeScale);
-            if (std::fabs(ec->stored - before) > 1e-3f) _saveDirty = true;
-            ec->manageCollectPrompt(_world, pb.sprite);
+            ec->manageCollectPrompt(_world, pb.sprite, _productionClock);
         }
         else if (auto gm = dynamic_cast<GoldMine*>(pb.data.get())) {
-            float before = gm->stored;
-            gm->updateProduction(dt, _timeScale);
-            if (std::fabs(gm->stored - before) > 1e-3f) _saveDirty = true;
-            gm->manageCollectPrompt(_world, pb.sprite);
+            gm->manageCollectPrompt(_world, pb.sprite, _productionClock);
         }
     }
+}
+
+void MainScene::update(float dt)
+{
+
+    updateBuildSystems(dt);
+
+
+    updateResearchSystems(dt);
+
+    // Production itself is analytic (Building::storedAt); only the collect prompts
+    // need refreshing, and a few times per second is plenty.
+    _productionClock += (double)dt * _timeScale;
+    _productionUiTimer += dt;
+    if (_productionUiTimer >= kProductionUiInterval) {
+        _productionUiTimer = 0.0f;
+        refreshCollectPrompts();
+    }
 
 
 
@@ -1009,6 +1022,8 @@ void MainScene::update(float dt)
     _autosaveTimer += dt;
     if (_autosaveTimer >= 2.0f)
     {
+        // A failed background write leaves the slot behind memory; write it again.
+        if (SaveSystem::takeWriteFailure(SaveSystem::getCurrentSlot())) _saveDirty = true;
         saveToCurrentSlot(false);
         _autosaveTimer = 0.0f;
     }
@@ -1117,10 +1132,12 @@ void MainScene::openUpgradeWindowForIndex(int idx)
 
 
             if (upgradeTime <= 0) {
+                pb.data->syncProduction(_productionClock);
                 pb.data->level = nextLv;
 
 
                 BuildingFactory::applyStats(pb.data.get(), pb.id, pb.data->level, true, false);
+                pb.data->restartProduction(_productionClock);
 
 
 
@@ -1145,6 +1162,8 @@ void MainScene::openUpgradeWindowForIndex(int idx)
             }
 
 
+            // Bank what was produced so far; storedAt() holds it while upgrading.
+            pb.data->syncProduction(_productionClock);
             pb.data->buildState = Building::STATE_UPGRADING;
             pb.data->buildTotalSec = (float)upgradeTime;
             pb.data->buildRemainSec = (float)upgradeTime;
@@ -1273,13 +1292,13 @@ void MainScene::setupInteraction()
                             r.origin -= Vec2(6.f, 4.f);
                             r.size.width += 12.f;
                             r.size.height += 8.f;
-                            if (r.containsPoint(local) && ec->canCollect()) {
-                                int deliver = ec->collect();
+                            if (r.containsPoint(local) && ec->canCollect(_productionClock)) {
+                                int deliver = ec->collect(_productionClock);
                                 if (deliver > 0) {
                                     SoundManager::playSfx("music/elixir_pump_pickup_07.ogg", 1.0f);
                                     _saveDirty = true;
                                 }
-                                ec->manageCollectPrompt(_world, pb.sprite);
+                                ec->manageCollectPrompt(_world, pb.sprite, _productionClock);
                                 return;
                             }
                         }
@@ -1290,13 +1309,13 @@ void MainScene::setupInteraction()
                             r.origin -= Vec2(6.f, 4.f);
                             r.size.width += 12.f;
                             r.size.height += 8.f;
-                            if (r.containsPoint(local) && gm->canCollect()) {
-                                int deliver = gm->collect();
+                            if (r.containsPoint(local) && gm->canCollect(_productionClock)) {
+                                int deliver = gm->collect(_productionClock);
                                 if (deliver > 0) {
                                     SoundManager::playSfx("music/goldmine_pickup4.ogg", 1.0f);
                                     _saveDirty = true;
                                 }
-                                gm->manageCollectPrompt(_world, pb.sprite);
+                                gm->manageCollectPrompt(_world, pb.sprite, _productionClock);
                                 return;
                             }
                         }
@@ -1330,7 +1349,7 @@ void MainScene::setupInteraction()
                     if (pb.data) {
                         auto ec = dynamic_cast<ElixirCollector*>(pb.data.get());
                         if (ec) {
-                            bool canCollect = ec->canCollect();
+                            bool canCollect = ec->canCollect(_productionClock);
                             if (pb.data->isFunctional() && canCollect) {
                                 int totalDeliver = 0;
                                 for (auto& it : _buildings) {
@@ -1339,7 +1358,7 @@ void MainScene::setupInteraction()
                                     if (auto ec2 = dynamic_cast<ElixirCollector*>(it.data.get())) {
 
 
-                                        totalDeliver += ec2->collect(true);
+                                        totalDeliver += ec2->collect(_productionClock, true);
                                     }
                                 }
                                 if (totalDeliver > 0) {
@@ -1355,9 +1374,9 @@ void MainScene::setupInteraction()
                             }
                         }
                         else if (auto gm = dynamic_cast<GoldMine*>(pb.data.get())) {
-                            bool canCollect = gm->canCollect();
+                            bool canCollect = gm->canCollect(_productionClock);
                             if (pb.data->isFunctional() && canCollect) {
-                                int deliver = gm->collect();
+                                int deliver = gm->collect(_productionClock);
                                 if (deliver > 0) {
                                     SoundManager::playSfx("music/goldmine_pickup4.ogg", 1.0f);
                                     _saveDirty = true;
@@ -1611,6 +1630,7 @@ void MainScene::placeBuilding(int r, int c, int id)
         }
     }
 
+    b->restartProduction(_productionClock);
     std::shared_ptr<Building> ptr(b.release());
     _buildings.push_back({ id, r, c, s, ptr });
 
@@ -1721,6 +1741,7 @@ void MainScene::commitMove(int r, int c)
     if (b.sprite) b.sprite->setPosition(center + off);
     b.r = r; b.c = c;
     redrawOccupied();
+    _productionUiTimer = kProductionUiInterval;   // move the collect prompt along
 
 
     playPlaceSfxForBuildingId(b.id);
@@ -1737,7 +1758,7 @@ void MainScene::cancelMove()
 void MainScene::loadFromCurrentSaveOrCreate()
 {
     int slot = SaveSystem::getCurrentSlot();
-    if (slot < 0 || slot >= 20)
+    if (slot < 0 || slot >= SaveSystem::kMaxSlots)
     {
         slot = 0;
         SaveSystem::setCurrentSlot(0);
@@ -1751,6 +1772,7 @@ void MainScene::loadFromCurrentSaveOrCreate()
         data = SaveSystem::makeDefault(slot, defName);
         SaveSystem::save(data);
     }
+    _saveName = data.name;
 
     for (auto& b : _buildings)
     {
@@ -1793,13 +1815,11 @@ void MainScene::loadFromCurrentSaveOrCreate()
                 if (b.buildState != Building::STATE_NORMAL) continue;
                 if (b.id == 3) {
                     auto st = ConfigManager::getElixirCollectorStats(std::max(1, b.level));
-                    float add = static_cast<float>(st.ratePerHour * (elapsed / 3600.0));
-                    b.stored = std::min((float)st.capacity, b.stored + add);
+                    b.stored = Building::storedAfter(b.stored, st.ratePerHour, st.capacity, elapsed);
                 }
                 else if (b.id == 5) {
                     auto st = ConfigManager::getGoldMineStats(std::max(1, b.level));
-                    float add = static_cast<float>(st.ratePerHour * (elapsed / 3600.0));
-                    b.stored = std::min((float)st.capacity, b.stored + add);
+                    b.stored = Building::storedAfter(b.stored, st.ratePerHour, st.capacity, elapsed);
                 }
             }
 
@@ -1873,20 +1893,15 @@ void MainScene::loadFromCurrentSaveOrCreate()
 
 void MainScene::saveToCurrentSlot(bool force)
 {
-    int slot = SaveSystem::getCurrentSlot();
-    if (slot < 0 || slot >= 20)
-    {
-        slot = 0;
-        SaveSystem::setCurrentSlot(0);
-    }
+    // loadFromCurrentSaveOrCreate already settled on a valid slot; saveAsync rejects
+    // anything else rather than writing over another village.
+    const int slot = SaveSystem::getCurrentSlot();
 
     if (!force && !_saveDirty) return;
 
     SaveData data;
     data.slot = slot;
-    SaveData prev;
-    if (SaveSystem::load(slot, prev)) data.name = prev.name;
-    else data.name = StringUtils::format("Save %02d", slot + 1);
+    data.name = _saveName.empty() ? StringUtils::format("Save %02d", slot + 1) : _saveName;
 
     data.gold = ResourceManager::getGold();
     data.elixir = ResourceManager::getElixir();
@@ -1924,7 +1939,7 @@ void MainScene::saveToCurrentSlot(bool force)
         {
             sb.level = b.data->level;
             sb.hp = b.data->hp;
-            sb.stored = b.data->stored;
+            sb.stored = b.data->storedAt(_productionClock);
 
 
             sb.buildState = b.data->buildState;
@@ -1935,7 +1950,9 @@ void MainScene::saveToCurrentSlot(bool force)
         data.buildings.push_back(sb);
     }
 
-    if (SaveSystem::save(data))
+    // Only the snapshot above runs on the frame thread; encoding and disk I/O happen
+    // on the save worker.
+    if (SaveSystem::saveAsync(std::move(data)))
     {
         _saveDirty = false;
     }
@@ -1986,6 +2003,7 @@ void MainScene::placeBuildingLoaded(int r, int c, const SaveBuilding& info)
     b->buildTotalSec = info.buildTotalSec;
     b->buildRemainSec = info.buildRemainSec;
     b->upgradeTargetLevel = info.upgradeTargetLevel;
+    b->restartProduction(_productionClock);
     auto s = b->createSprite();
     Vec2 center(_anchor.x + (c - r) * (_tileW * 0.5f), _anchor.y - (c + r) * (_tileH * 0.5f));
     int idx = std::max(1, std::min(11, info.id));
@@ -2046,13 +2064,34 @@ void MainScene::openAttackTargetPicker()
     panel->addChild(closeMenu, 2);
 
 
-    auto metasAll = SaveSystem::listAllSlots();
-    std::vector<SaveMeta> targets;
-    targets.reserve(metasAll.size());
-    for (const auto& m : metasAll)
+    // Only the current page of targets is fetched and laid out.
+    const int currentSlot = SaveSystem::getCurrentSlot();
+    const int totalTargets = SaveSystem::countSlots(currentSlot);
+    const int pages = std::max(1, (totalTargets + kAttackPageSize - 1) / kAttackPageSize);
+    _attackPage = std::min(std::max(_attackPage, 0), pages - 1);
+    std::vector<SaveMeta> targets = SaveSystem::listSlots(_attackPage * kAttackPageSize, kAttackPageSize, currentSlot);
+
+    if (pages > 1)
     {
-        if (m.exists && m.slot != SaveSystem::getCurrentSlot())
-            targets.push_back(m);
+        auto turnPage = [this](int delta) {
+            _attackPage += delta;
+            closeAttackTargetPicker();
+            openAttackTargetPicker();
+        };
+        auto prevLabel = Label::createWithSystemFont("<", "Arial", 36);
+        auto prevItem = MenuItemLabel::create(prevLabel, [turnPage](Ref*) { turnPage(-1); });
+        prevItem->setPosition(Vec2(panelW / 2 - 80, 30));
+        auto nextLabel = Label::createWithSystemFont(">", "Arial", 36);
+        auto nextItem = MenuItemLabel::create(nextLabel, [turnPage](Ref*) { turnPage(1); });
+        nextItem->setPosition(Vec2(panelW / 2 + 80, 30));
+        auto pageMenu = Menu::create(prevItem, nextItem, nullptr);
+        pageMenu->setPosition(Vec2::ZERO);
+        panel->addChild(pageMenu, 2);
+
+        auto pageLabel = Label::createWithSystemFont(
+            StringUtils::format("%d/%d", _attackPage + 1, pages), "Arial", 24);
+        pageLabel->setPosition(Vec2(panelW / 2, 30));
+        panel->addChild(pageLabel);
     }
 
 
@@ -2108,6 +2147,13 @@ void MainScene::openAttackTargetPicker()
             label->setPosition(Vec2(16, (rowH - 6) * 0.5f));
             rowBg->addChild(label);
 
+            std::string summaryText = StringUtils::format("TH%d  %dG  %dE",
+                meta.townHallLevel, meta.lootGold, meta.lootElixir);
+            auto summary = Label::createWithSystemFont(summaryText, "Arial", 18);
+            summary->setAnchorPoint(Vec2(1.0f, 0.5f));
+            summary->setPosition(Vec2(_attackScroll->getContentSize().width - 120, (rowH - 6) * 0.5f));
+            rowBg->addChild(summary);
+
             auto attackLabel = Label::createWithSystemFont("Attack", "Arial", 26);
             auto attackItem = MenuItemLabel::create(attackLabel, [this, meta](Ref*) {
                 SaveSystem::setBattleTargetSlot(meta.slot);
@@ -160,6 +160,12 @@ private:
     // Returns the TownHallLevel.
     int getTownHallLevel() const;
     float _timeScale = 1.0f;
+    // Time-scaled seconds since the village was loaded; the clock producers use.
+    double _productionClock = 0.0;
+    static constexpr float kProductionUiInterval = 0.25f;
+    float _productionUiTimer = 0.0f;
+    // Shows or hides the collect prompts of mines and collectors.
+    void refreshCollectPrompts();
     // TODO: Add a brief description.
     int countById(int id) const;
     // Builds and configures resources.
@@ -189,6 +195,7 @@ private:
     void placeBuildingLoaded(int r, int c, const SaveBuilding& info);
 
     bool _saveDirty = false;
+    std::string _saveName;   // slot name, kept so autosaves need not reload the slot
     float _autosaveTimer = 0.0f;
 
 
@@ -203,6 +210,8 @@ private:
     cocos2d::ui::ScrollView* _attackScroll = nullptr;
     cocos2d::Node* _attackContent = nullptr;
     cocos2d::EventListenerMouse* _attackMouseListener = nullptr;
+    int _attackPage = 0;
+    static constexpr int kAttackPageSize = 50;
 
 
     // TODO: Add a brief description.
@@ -4,6 +4,7 @@
 
 #include "Scenes/MainScene.h"
 #include "Data/SaveSystem.h"
+#include "Data/SaveWorker.h"
 
 #include "ui/CocosGUI.h"
 
@@ -64,6 +65,9 @@ bool MenuScene::init()
 
     auto exitLabel = Label::createWithSystemFont("Exit Game", "Arial", 46);
     auto exitItem = MenuItemLabel::create(exitLabel, [](Ref*) {
+        // Saves queued by the village scene may still be in flight; ExitProcess
+        // would kill the save worker before they reach the disk.
+        SaveWorker::shutdown();
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32)
         ExitProcess(0);
 #else
@@ -84,17 +88,13 @@ return true;
 
 void MenuScene::createNewSaveAndEnter()
 {
-    int chosenSlot = -1;
-    for (int i = 0; i < 20; ++i)
-    {
-        if (!SaveSystem::exists(i)) { chosenSlot = i; break; }
-    }
+    int chosenSlot = SaveSystem::findFreeSlot();
 
     if (chosenSlot < 0)
     {
         auto visibleSize = Director::getInstance()->getVisibleSize();
         auto origin = Director::getInstance()->getVisibleOrigin();
-        auto tip = Label::createWithSystemFont("No empty slot (max 20)", "Arial", 32);
+        auto tip = Label::createWithSystemFont(StringUtils::format("No empty slot (max %d)", SaveSystem::kMaxSlots), "Arial", 32);
         tip->setPosition(origin + Vec2(visibleSize.width / 2, visibleSize.height * 0.28f));
         tip->setColor(Color3B::YELLOW);
         this->addChild(tip, 5);
@@ -137,6 +137,7 @@ _saveMask->removeFromParent();
         _saveMask = nullptr;
         _saveScroll = nullptr;
         _saveContent = nullptr;
+        _savePageLabel = nullptr;
     }
 }
 
@@ -183,6 +184,31 @@ void MenuScene::buildSaveUI()
     header->setPosition(Vec2(panelW / 2, panelH - 50));
     panel->addChild(header);
 
+    // One page of kSavePageSize saves is listed at a time.
+    auto prevLabel = Label::createWithSystemFont("<", "Arial", 40);
+    prevLabel->setColor(Color3B::BLACK);
+    auto prevItem = MenuItemLabel::create(prevLabel, [this](Ref*) {
+        if (_savePage <= 0) return;
+        --_savePage;
+        this->refreshSaveList();
+    });
+    prevItem->setPosition(Vec2(40, panelH - 50));
+    auto nextLabel = Label::createWithSystemFont(">", "Arial", 40);
+    nextLabel->setColor(Color3B::BLACK);
+    auto nextItem = MenuItemLabel::create(nextLabel, [this](Ref*) {
+        ++_savePage;
+        this->refreshSaveList();
+    });
+    nextItem->setPosition(Vec2(180, panelH - 50));
+    auto pageMenu = Menu::create(prevItem, nextItem, nullptr);
+    pageMenu->setPosition(Vec2::ZERO);
+    panel->addChild(pageMenu, 2);
+
+    _savePageLabel = Label::createWithSystemFont("", "Arial", 26);
+    _savePageLabel->setColor(Color3B::BLACK);
+    _savePageLabel->setPosition(Vec2(110, panelH - 50));
+    panel->addChild(_savePageLabel);
+
     
     auto closeLabel = Label::createWithSystemFont("X", "Arial", 44);
     closeLabel->setColor(Color3B::BLACK);
@@ -246,13 +272,11 @@ void MenuScene::refreshSaveList()
 {
     if (!_saveScroll || !_saveContent) return;
 
-    auto metasAll = SaveSystem::listAllSlots();
-    std::vector<SaveMeta> metas;
-    metas.reserve(metasAll.size());
-    for (const auto& m : metasAll)
-    {
-        if (m.exists) metas.push_back(m);
-    }
+    const int total = SaveSystem::countSlots();
+    const int pages = std::max(1, (total + kSavePageSize - 1) / kSavePageSize);
+    _savePage = std::min(std::max(_savePage, 0), pages - 1);
+    if (_savePageLabel) _savePageLabel->setString(StringUtils::format("%d/%d", _savePage + 1, pages));
+    std::vector<SaveMeta> metas = SaveSystem::listSlots(_savePage * kSavePageSize, kSavePageSize);
 
     _saveContent->removeAllChildren();
 
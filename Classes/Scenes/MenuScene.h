@@ -42,6 +42,9 @@ private:
     cocos2d::LayerColor* _saveMask = nullptr;
     cocos2d::ui::ScrollView* _saveScroll = nullptr;
     cocos2d::Node* _saveContent = nullptr;
+    cocos2d::Label* _savePageLabel = nullptr;
+    int _savePage = 0;
+    static constexpr int kSavePageSize = 50;
     cocos2d::Node* _savePanel = nullptr;
     cocos2d::EventListenerMouse* _saveMouseListener = nullptr;
 };
@@ -1,6 +1,7 @@
 #include "Systems/AISystem.h"
 
 #include "Systems/CombatSystem.h"
+#include "Systems/CombatLog.h"
 #include "Systems/Pathfinding.h"
 
 #include "GameObjects/Buildings/DefenseBuilding.h"
@@ -19,6 +20,11 @@ void AISystem::setIsoGrid(int rows, int cols, float tileW, float tileH, const Ve
     _tileH = tileH;
     _anchor = anchor;
     _gridReady = (_rows > 0 && _cols > 0 && _tileW > 0.001f && _tileH > 0.001f);
+
+    // Cached building cells depend on the grid; they are rebuilt by prepareBuildings.
+    _buildingCells.clear();
+    _cellPool.clear();
+    _buildingIndex.clear();
 }
 
 Vec2 AISystem::gridToWorld(int r, int c) const
@@ -115,41 +121,100 @@ void AISystem::buildBlockedMap(const std::vector<EnemyBuildingRuntime>& enemyBui
     }
 }
 
-void AISystem::getFootprintCells(const EnemyBuildingRuntime& target,
-    std::vector<Pathfinding::GridPos>& out) const
+void AISystem::prepareBuildings(std::vector<EnemyBuildingRuntime>& enemyBuildings)
 {
-    out.clear();
+    _buildingCells.clear();
+    _cellPool.clear();
+    _distPool.clear();
+    for (auto& e : enemyBuildings) e.cellsSlot = -1;
+    _buildingIndex.build(enemyBuildings, _rows, _cols);
     if (!_gridReady) return;
 
-    int tr = target.r;
-    int tc = target.c;
-    if (tr < 0 || tr >= _rows || tc < 0 || tc >= _cols)
-    {
-        auto g = worldToGrid(target.pos);
-        tr = g.r;
-        tc = g.c;
-    }
+    _buildingCells.reserve(enemyBuildings.size());
+    // Footprint plus two rings is at most a few dozen cells per building.
+    _cellPool.reserve(enemyBuildings.size() * 9 * 4);
+    _distPool.reserve(enemyBuildings.size() * DIST_SIZE * DIST_STRIDE);
 
-    auto pushIfInside = [&](int rr, int cc) {
-        if (rr < 0 || rr >= _rows || cc < 0 || cc >= _cols) return;
-        out.push_back({ rr, cc });
+    // Per-cell stamp used to dedupe ring cells without clearing a mask per building.
+    std::vector<int> stamp((size_t)_rows * (size_t)_cols, -1);
+    int stampId = 0;
+
+    auto inside = [&](int rr, int cc) -> bool {
+        return rr >= 0 && rr < _rows && cc >= 0 && cc < _cols;
     };
 
-    if (target.id == 10)
+    for (auto& e : enemyBuildings)
     {
-        pushIfInside(tr, tc);
-        return;
-    }
+        BuildingCells bc;
+        bc.center = computeCenterCell(e);
+
+        // Walls occupy one cell, every other building a 3x3 block around its center.
+        bc.footBegin = (int)_cellPool.size();
+        const int fr = (e.id == 10) ? 0 : 1;
+        for (int dr = -fr; dr <= fr; ++dr)
+            for (int dc = -fr; dc <= fr; ++dc)
+                if (inside(bc.center.r + dr, bc.center.c + dc))
+                    _cellPool.push_back({ bc.center.r + dr, bc.center.c + dc });
+        bc.footRadius = fr;
+        bc.footCount = (int)_cellPool.size() - bc.footBegin;
+
+        // Distance window: seed the footprint with 0 and let the transform fill the rest.
+        bc.distBegin = (int)_distPool.size();
+        _distPool.resize(_distPool.size() + (size_t)DIST_SIZE * DIST_STRIDE, DIST_FAR);
+        unsigned char* dist = _distPool.data() + bc.distBegin;
+        for (int dr = -fr; dr <= fr; ++dr)
+            for (int dc = -fr; dc <= fr; ++dc)
+                dist[(size_t)(dr + DIST_RADIUS) * DIST_STRIDE + (size_t)(dc + DIST_RADIUS)] = 0;
+        Pathfinding::chebyshevDistanceTransform(dist, DIST_SIZE, DIST_SIZE, DIST_STRIDE);
+
+        // Ring of cells within `range` (Chebyshev) of the footprint, excluding the
+        // footprint itself. Order matches the old per-call scan so path tie-breaks stay the same.
+        auto buildRing = [&](int range, int& outBegin, int& outCount) {
+            const int footId = stampId++;
+            const int ringId = stampId++;
+            for (int k = 0; k < bc.footCount; ++k)
+            {
+                const auto& f = _cellPool[(size_t)(bc.footBegin + k)];
+                stamp[(size_t)f.r * (size_t)_cols + (size_t)f.c] = footId;
+            }
+
+            outBegin = (int)_cellPool.size();
+            for (int k = 0; k < bc.footCount; ++k)
+            {
+                const Pathfinding::GridPos f = _cellPool[(size_t)(bc.footBegin + k)];
+                for (int dr = -range; dr <= range; ++dr)
+                {
+                    for (int dc = -range; dc <= range; ++dc)
+                    {
+                        int rr = f.r + dr;
+                        int cc = f.c + dc;
+                        if (!inside(rr, cc)) continue;
+                        int& st = stamp[(size_t)rr * (size_t)_cols + (size_t)cc];
+                        if (st == footId || st == ringId) continue;
+                        st = ringId;
+                        _cellPool.push_back({ rr, cc });
+                    }
+                }
+            }
+            outCount = (int)_cellPool.size() - outBegin;
+        };
+
+        buildRing(MELEE_APPROACH_RANGE, bc.meleeRingBegin, bc.meleeRingCount);
+        buildRing(ARCHER_APPROACH_RANGE, bc.archerRingBegin, bc.archerRingCount);
 
-    for (int dr = -1; dr <= 1; ++dr)
-        for (int dc = -1; dc <= 1; ++dc)
-            pushIfInside(tr + dr, tc + dc);
+        e.cellsSlot = (int)_buildingCells.size();
+        _buildingCells.push_back(bc);
+    }
 }
 
-Pathfinding::GridPos AISystem::getCenterCell(const EnemyBuildingRuntime& target) const
+const AISystem::BuildingCells* AISystem::cellsOf(const EnemyBuildingRuntime& target) const
 {
-    if (!_gridReady) return { 0, 0 };
+    if (target.cellsSlot < 0 || target.cellsSlot >= (int)_buildingCells.size()) return nullptr;
+    return &_buildingCells[(size_t)target.cellsSlot];
+}
 
+Pathfinding::GridPos AISystem::computeCenterCell(const EnemyBuildingRuntime& target) const
+{
     int tr = target.r;
     int tc = target.c;
     if (tr < 0 || tr >= _rows || tc < 0 || tc >= _cols)
@@ -161,8 +226,55 @@ Pathfinding::GridPos AISystem::getCenterCell(const EnemyBuildingRuntime& target)
     return { tr, tc };
 }
 
-bool AISystem::inAttackRangeCells(const UnitBase& unit,
-    const Pathfinding::GridPos& unitCell,
+AISystem::CellSpan AISystem::getFootprintCells(const EnemyBuildingRuntime& target) const
+{
+    CellSpan span;
+    const BuildingCells* bc = cellsOf(target);
+    if (!bc) return span;
+    span.first = _cellPool.data() + bc->footBegin;
+    span.count = bc->footCount;
+    return span;
+}
+
+unsigned char AISystem::footprintDistance(const BuildingCells& bc, const Pathfinding::GridPos& cell) const
+{
+    const int wr = cell.r - bc.center.r + DIST_RADIUS;
+    const int wc = cell.c - bc.center.c + DIST_RADIUS;
+    if (wr < 0 || wr >= DIST_SIZE || wc < 0 || wc >= DIST_SIZE) return DIST_FAR;
+    return _distPool[(size_t)bc.distBegin + (size_t)wr * DIST_STRIDE + (size_t)wc];
+}
+
+void AISystem::collectCellsWithin(const BuildingCells& bc, int maxDist,
+    const std::vector<unsigned char>& blocked,
+    std::vector<Pathfinding::GridPos>& out) const
+{
+    const unsigned char* dist = _distPool.data() + bc.distBegin;
+    for (int wr = 0; wr < DIST_SIZE; ++wr)
+    {
+        const int rr = bc.center.r + wr - DIST_RADIUS;
+        if (rr < 0 || rr >= _rows) continue;
+        for (int wc = 0; wc < DIST_SIZE; ++wc)
+        {
+            if ((int)dist[(size_t)wr * DIST_STRIDE + (size_t)wc] > maxDist) continue;
+            const int cc = bc.center.c + wc - DIST_RADIUS;
+            if (cc < 0 || cc >= _cols) continue;
+            size_t idx = (size_t)rr * (size_t)_cols + (size_t)cc;
+            if (idx >= blocked.size() || blocked[idx] != 0) continue;
+            out.push_back({ rr, cc });
+        }
+    }
+}
+
+Pathfinding::GridPos AISystem::getCenterCell(const EnemyBuildingRuntime& target) const
+{
+    if (!_gridReady) return { 0, 0 };
+
+    if (const BuildingCells* bc = cellsOf(target)) return bc->center;
+    return computeCenterCell(target);
+}
+
+template <typename Traits>
+bool AISystem::inAttackRangeCells(const Pathfinding::GridPos& unitCell,
     const EnemyBuildingRuntime& target) const
 {
     if (!_gridReady) return false;
@@ -172,6 +284,16 @@ bool AISystem::inAttackRangeCells(const UnitBase& unit,
     
     
 
+    if (const BuildingCells* bc = cellsOf(target))
+    {
+        // Melee units attack buildings from the center cell; everything else is a
+        // threshold on the precomputed distance to the footprint.
+        if (!Traits::ranged && target.id != 10)
+            return unitCell.r == bc->center.r && unitCell.c == bc->center.c;
+
+        return (int)footprintDistance(*bc, unitCell) <= Traits::approachRange - bc->footRadius;
+    }
+
     Pathfinding::GridPos center = getCenterCell(target);
     int dr = std::abs(unitCell.r - center.r);
     int dc = std::abs(unitCell.c - center.c);
@@ -180,77 +302,44 @@ bool AISystem::inAttackRangeCells(const UnitBase& unit,
     if (target.id == 10)
     {
         
-        if (isArcher(unit)) return (cheb <= 3);
+        if (Traits::ranged) return (cheb <= Traits::approachRange);
         return (cheb <= 1);
     }
 
-    if (isArcher(unit)) return (cheb <= 3);
+    if (Traits::ranged) return (cheb <= Traits::approachRange);
     
     return (cheb == 0);
 }
 
-void AISystem::collectApproachCells(const UnitBase& unit,
-    const EnemyBuildingRuntime& target,
+template <typename Traits>
+void AISystem::collectApproachCells(const EnemyBuildingRuntime& target,
     const std::vector<unsigned char>& blocked,
     std::vector<Pathfinding::GridPos>& out) const
 {
     out.clear();
     if (!_gridReady) return;
 
-    std::vector<Pathfinding::GridPos> footprint;
-    getFootprintCells(target, footprint);
-    if (footprint.empty()) return;
-
-    auto isPassable = [&](int rr, int cc) -> bool {
-        if (rr < 0 || rr >= _rows || cc < 0 || cc >= _cols) return false;
-        size_t idx = (size_t)rr * (size_t)_cols + (size_t)cc;
-        if (idx >= blocked.size()) return false;
-        return blocked[idx] == 0;
-    };
-
-    
-    std::vector<unsigned char> isFoot((size_t)_rows * (size_t)_cols, 0);
-    for (const auto& bc : footprint)
-    {
-        size_t idx = (size_t)bc.r * (size_t)_cols + (size_t)bc.c;
-        if (idx < isFoot.size()) isFoot[idx] = 1;
-    }
+    const BuildingCells* bc = cellsOf(target);
+    if (!bc) return;
 
-    std::vector<unsigned char> visited((size_t)_rows * (size_t)_cols, 0);
-    auto pushUnique = [&](int rr, int cc) {
-        if (!isPassable(rr, cc)) return;
-        size_t idx = (size_t)rr * (size_t)_cols + (size_t)cc;
-        if (idx >= visited.size()) return;
-        if (visited[idx]) return;
-        visited[idx] = 1;
-        out.push_back({ rr, cc });
-    };
+    // Archers can hit walls from 3 cells away; melee units need to be adjacent.
+    static_assert(Traits::approachRange == ARCHER_APPROACH_RANGE || Traits::approachRange == MELEE_APPROACH_RANGE,
+        "approach rings are only precomputed for the melee and archer ranges");
+    const bool archer = (Traits::approachRange == ARCHER_APPROACH_RANGE);
+    const int begin = archer ? bc->archerRingBegin : bc->meleeRingBegin;
+    const int count = archer ? bc->archerRingCount : bc->meleeRingCount;
 
-    
-    
-    const int range = isArcher(unit) ? 3 : 1;
-    for (const auto& bc : footprint)
+    for (int k = 0; k < count; ++k)
     {
-        for (int dr = -range; dr <= range; ++dr)
-        {
-            for (int dc = -range; dc <= range; ++dc)
-            {
-                
-                if (std::max(std::abs(dr), std::abs(dc)) > range) continue;
-
-                int rr = bc.r + dr;
-                int cc = bc.c + dc;
-                if (rr < 0 || rr >= _rows || cc < 0 || cc >= _cols) continue;
-                size_t idx = (size_t)rr * (size_t)_cols + (size_t)cc;
-                if (idx < isFoot.size() && isFoot[idx]) continue; 
-                pushUnique(rr, cc);
-            }
-        }
+        const auto& g = _cellPool[(size_t)(begin + k)];
+        size_t idx = (size_t)g.r * (size_t)_cols + (size_t)g.c;
+        if (idx >= blocked.size() || blocked[idx] != 0) continue;
+        out.push_back(g);
     }
 }
 
-int AISystem::pickWallToBreak(const UnitBase& unit,
-    const Pathfinding::GridPos& unitCell,
+template <typename Traits>
+int AISystem::pickWallToBreak(const Pathfinding::GridPos& unitCell,
     const Pathfinding::GridPos& mainTargetCenter,
     const std::vector<EnemyBuildingRuntime>& enemyBuildings,
     const std::vector<unsigned char>& blockedHard) const
@@ -258,7 +347,7 @@ int AISystem::pickWallToBreak(const UnitBase& unit,
     if (!_gridReady) return -1;
 
     
-    if (isArcher(unit) || isBomber(unit)) return -1;
+    if (Traits::walls != UnitWallHandling::Attack) return -1;
 
     std::vector<unsigned char> blk = blockedHard;
     if ((int)blk.size() != _rows * _cols)
@@ -328,8 +417,8 @@ int AISystem::pickWallToBreak(const UnitBase& unit,
     return bestIdx;
 }
 
-int AISystem::pickTargetIndex(const UnitBase& unit,
-    const Pathfinding::GridPos& unitCell,
+template <typename Traits>
+int AISystem::pickTargetIndex(const Pathfinding::GridPos& unitCell,
     const std::vector<EnemyBuildingRuntime>& enemyBuildings,
     const std::vector<unsigned char>& blocked) const
 {
@@ -379,7 +468,7 @@ int AISystem::pickTargetIndex(const UnitBase& unit,
     int bestD = INT_MAX;
 
     // 1) Bomber: nearest wall, fallback to any non-wall.
-    if (isBomber(unit))
+    if (Traits::target == UnitTargetPreference::Walls)
     {
         auto matchWall = [](const EnemyBuildingRuntime& e) -> bool { return e.id == 10; };
         auto matchNonWall = [](const EnemyBuildingRuntime& e) -> bool { return e.id != 10; };
@@ -392,7 +481,7 @@ int AISystem::pickTargetIndex(const UnitBase& unit,
     }
 
     // 2) Giant: nearest defense if any exist.
-    if (isGiant(unit) && defensesExist)
+    if (Traits::target == UnitTargetPreference::Defenses && defensesExist)
     {
         auto matchDefense = [](const EnemyBuildingRuntime& e) -> bool {
             return (e.id == 1 || e.id == 2);  // Arrow tower or cannon.
@@ -403,7 +492,7 @@ int AISystem::pickTargetIndex(const UnitBase& unit,
     }
 
     // 3) Archer: explicitly nearest non-wall (no resource priority).
-    if (isArcher(unit))
+    if (Traits::ranged)
     {
         auto matchNonWall = [](const EnemyBuildingRuntime& e) -> bool { return e.id != 10; };
         findNearest(&best, &bestD, matchNonWall);
@@ -416,8 +505,8 @@ int AISystem::pickTargetIndex(const UnitBase& unit,
     return best;
 }
 
-bool AISystem::buildBestPathForTarget(const UnitBase& unit,
-    const Pathfinding::GridPos& start,
+template <typename Traits>
+bool AISystem::buildBestPathForTarget(const Pathfinding::GridPos& start,
     const EnemyBuildingRuntime& target,
     const std::vector<unsigned char>& blockedHard,
     std::vector<Pathfinding::GridPos>& outPath) const
@@ -439,9 +528,15 @@ bool AISystem::buildBestPathForTarget(const UnitBase& unit,
     if (target.id == 10)
     {
         
-        collectApproachCells(unit, target, blk, goals);
+        collectApproachCells<Traits>(target, blk, goals);
     }
-    else if (isArcher(unit))
+    else if (Traits::ranged && cellsOf(target))
+    {
+        // Archers may stand anywhere within 3 cells of the building center.
+        const BuildingCells& bc = *cellsOf(target);
+        collectCellsWithin(bc, Traits::approachRange - bc.footRadius, blk, goals);
+    }
+    else if (Traits::ranged)
     {
         
         Pathfinding::GridPos center = getCenterCell(target);
@@ -507,8 +602,8 @@ bool AISystem::buildBestPathForTarget(const UnitBase& unit,
     return true;
 }
 
-int AISystem::pickReachableTargetIndex(const UnitBase& unit,
-    const Pathfinding::GridPos& unitCell,
+template <typename Traits>
+int AISystem::pickReachableTargetIndex(const Pathfinding::GridPos& unitCell,
     const std::vector<EnemyBuildingRuntime>& enemyBuildings,
     const std::vector<unsigned char>& blockedHard,
     std::vector<Pathfinding::GridPos>* outBestPath) const
@@ -526,13 +621,13 @@ int AISystem::pickReachableTargetIndex(const UnitBase& unit,
     std::vector<int> candidates;
     candidates.reserve(enemyBuildings.size());
 
-    if (isBomber(unit))
+    if (Traits::target == UnitTargetPreference::Walls)
     {
         
         return -1;
     }
 
-    if (isGiant(unit) && defensesExist)
+    if (Traits::target == UnitTargetPreference::Defenses && defensesExist)
     {
         for (int i = 0; i < (int)enemyBuildings.size(); ++i)
         {
@@ -573,7 +668,7 @@ int AISystem::pickReachableTargetIndex(const UnitBase& unit,
     for (int idx : candidates)
     {
         std::vector<Pathfinding::GridPos> path;
-        if (!buildBestPathForTarget(unit, unitCell, enemyBuildings[idx], blockedHard, path))
+        if (!buildBestPathForTarget<Traits>(unitCell, enemyBuildings[idx], blockedHard, path))
             continue;
 
         int len = (int)path.size();
@@ -594,6 +689,7 @@ int AISystem::pickReachableTargetIndex(const UnitBase& unit,
     return bestIdx;
 }
 
+template <typename Traits>
 void AISystem::recomputePath(BattleUnitRuntime& u,
     const EnemyBuildingRuntime& target,
     const std::vector<unsigned char>& blocked)
@@ -617,9 +713,15 @@ void AISystem::recomputePath(BattleUnitRuntime& u,
     if (target.id == 10)
     {
         
-        collectApproachCells(*u.unit, target, blk, goals);
+        collectApproachCells<Traits>(target, blk, goals);
+    }
+    else if (Traits::ranged && cellsOf(target))
+    {
+        // Archers may stand anywhere within 3 cells of the building center.
+        const BuildingCells& bc = *cellsOf(target);
+        collectCellsWithin(bc, Traits::approachRange - bc.footRadius, blk, goals);
     }
-    else if (isArcher(*u.unit))
+    else if (Traits::ranged)
     {
         
         Pathfinding::GridPos center = getCenterCell(target);
@@ -688,7 +790,8 @@ void AISystem::recomputePath(BattleUnitRuntime& u,
 }
 
 void AISystem::stepAlongPath(BattleUnitRuntime& u,
-    float dt)
+    float dt,
+    const Vec2& offset)
 {
     if (!u.sprite || !u.unit) return;
     if (!_gridReady) return;
@@ -703,6 +806,9 @@ void AISystem::stepAlongPath(BattleUnitRuntime& u,
     auto cell = u.path[u.pathCursor];
     Vec2 waypoint = gridToWorld(cell.r, cell.c);
 
+    // The last waypoint is the attack cell; always step onto it exactly.
+    if (u.pathCursor + 1 < (int)u.path.size()) waypoint += offset;
+
     Vec2 next = Pathfinding::stepTowards(cur, waypoint, u.unit->moveSpeed * dt, 0.0f);
     u.sprite->setPosition(next);
 
@@ -712,6 +818,231 @@ void AISystem::stepAlongPath(BattleUnitRuntime& u,
     }
 }
 
+void AISystem::applySeparation(float dt, std::vector<BattleUnitRuntime>& units,
+    const std::vector<EnemyBuildingRuntime>& enemyBuildings)
+{
+    const float radius = SEPARATION_RADIUS_CELLS * _cellSizePx;
+    if (radius <= 0.001f) return;
+
+    // Same blocking rules the pathfinder used for each unit type.
+    buildBlockedMap(enemyBuildings, _separationBlocked, true, false);
+    buildBlockedMap(enemyBuildings, _separationBlockedCenters, true, true);
+
+    _separationPush.assign(units.size(), Vec2::ZERO);
+
+    // Jacobi pass: every push is computed from the same position snapshot.
+    for (int i = 0; i < (int)units.size(); ++i)
+    {
+        const auto& u = units[i];
+        if (!_unitHash.contains(i)) continue;
+
+        // Units standing at their attack cell are anchors; only travelling units yield.
+        if (u.path.empty() || u.pathCursor >= (int)u.path.size()) continue;
+
+        const Vec2 p = _unitHash.positionOf(i);
+        Vec2 push = Vec2::ZERO;
+        _unitHash.forEachInRadius(p, radius, [&](int j, float d2) {
+            if (j == i) return;
+            const Vec2 q = _unitHash.positionOf(j);
+            if (d2 < 0.0001f)
+            {
+                // Exactly stacked: separate deterministically by index.
+                push.x += (i < j) ? -1.0f : 1.0f;
+                return;
+            }
+            const float d = std::sqrt(d2);
+            push += (p - q) * ((radius - d) / (radius * d));
+        });
+        _separationPush[(size_t)i] = push;
+    }
+
+    for (int i = 0; i < (int)units.size(); ++i)
+    {
+        Vec2 push = _separationPush[(size_t)i];
+        if (push.x == 0.0f && push.y == 0.0f) continue;
+
+        auto& u = units[i];
+        const float maxStep = u.unit->moveSpeed * SEPARATION_SPEED_RATIO * dt;
+        const float len = push.length();
+        if (len > 1.0f) push = push / len;
+        const Vec2 cur = _unitHash.positionOf(i);
+        Vec2 next = cur + push * maxStep;
+
+        if (_gridReady)
+        {
+            const auto& blocked = getUnitTraitsRow(u.unit->unitId).blockedCentersOnly
+                ? _separationBlockedCenters : _separationBlocked;
+            const auto from = worldToGrid(cur);
+            auto enterable = [&](const Vec2& p) {
+                const auto g = worldToGrid(p);
+                if (g.r == from.r && g.c == from.c) return true;
+                const size_t idx = (size_t)g.r * (size_t)_cols + (size_t)g.c;
+                return idx >= blocked.size() || blocked[idx] == 0;
+            };
+            // Slide along a blocked edge on one axis; otherwise stay put.
+            if (!enterable(next))
+            {
+                const Vec2 alongX(next.x, cur.y);
+                const Vec2 alongY(cur.x, next.y);
+                if (enterable(alongX)) next = alongX;
+                else if (enterable(alongY)) next = alongY;
+                else continue;
+            }
+        }
+
+        u.sprite->setPosition(next);
+        _unitHash.setPosition(i, next);
+    }
+}
+
+void AISystem::assignSquad(BattleUnitRuntime& u)
+{
+    u.squadId = -1;
+    u.formationOffset = Vec2::ZERO;
+    if (!u.unit || !u.sprite) return;
+
+    const Vec2 pos = u.sprite->getPosition();
+    const float joinRadius = SQUAD_JOIN_RADIUS_CELLS * _cellSizePx;
+
+    for (int i = (int)_squads.size() - 1; i >= 0; --i)
+    {
+        Squad& sq = _squads[(size_t)i];
+        if (_battleTime - sq.lastJoinTime > SQUAD_JOIN_WINDOW) continue;
+        if (sq.unitId != u.unit->unitId || sq.size >= SQUAD_MAX_SIZE) continue;
+        if (pos.distanceSquared(sq.anchor) > joinRadius * joinRadius) continue;
+
+        // Keep the offset inside the current cell so followers stay on the leader's corridor.
+        Vec2 off = pos - sq.anchor;
+        const float maxOff = 0.3f * std::min(_tileW, _tileH);
+        const float len = off.length();
+        if (len > maxOff && len > 0.0001f) off = off * (maxOff / len);
+
+        u.squadId = i;
+        u.formationOffset = off;
+        sq.lastJoinTime = _battleTime;
+        sq.size++;
+        return;
+    }
+
+    Squad sq;
+    sq.unitId = u.unit->unitId;
+    sq.anchor = pos;
+    sq.lastJoinTime = _battleTime;
+    sq.size = 1;
+    u.squadId = (int)_squads.size();
+    _squads.push_back(sq);
+}
+
+void AISystem::updateSquadLeaders(const std::vector<BattleUnitRuntime>& units)
+{
+    _squadLeaders.assign(_squads.size(), -1);
+    for (int i = 0; i < (int)units.size(); ++i)
+    {
+        const auto& u = units[i];
+        if (u.squadId < 0 || u.squadId >= (int)_squadLeaders.size()) continue;
+        if (!u.unit || !u.sprite || u.unit->isDead() || u.dying) continue;
+        int& leader = _squadLeaders[(size_t)u.squadId];
+        if (leader < 0) leader = i;
+    }
+}
+
+template <typename Traits>
+bool AISystem::followSquadLeader(float dt, BattleUnitRuntime& u,
+    const BattleUnitRuntime& leader,
+    std::vector<EnemyBuildingRuntime>& enemyBuildings)
+{
+    if (!_gridReady) return false;
+    if (!u.unit || !u.sprite || u.unit->isDead()) return false;
+    if (!leader.unit || !leader.sprite || leader.unit->isDead()) return false;
+
+    auto isValidIndex = [&](int idx) -> bool {
+        if (idx < 0 || idx >= (int)enemyBuildings.size()) return false;
+        const auto& t = enemyBuildings[idx];
+        return (t.building && t.building->hp > 0 && t.sprite);
+    };
+
+    const auto unitCell = worldToGrid(u.sprite->getPosition());
+
+    // A follower that is already hitting a live target keeps doing so.
+    const bool engaged = isValidIndex(u.targetIndex)
+        && inAttackRangeCells<Traits>(unitCell, enemyBuildings[u.targetIndex]);
+
+    if (!engaged)
+    {
+        if (!isValidIndex(leader.targetIndex)) return false;
+
+        // Routes diverged (wall got in the way, leader detoured): go solo for good.
+        const float leash = SQUAD_LEASH_CELLS * std::max(_tileW, _tileH);
+        if (u.sprite->getPosition().distanceSquared(leader.sprite->getPosition()) > leash * leash)
+        {
+            u.squadId = -1;
+            return false;
+        }
+
+        const bool leaderMoving = !leader.path.empty() && leader.pathCursor < (int)leader.path.size();
+        const bool inRange = inAttackRangeCells<Traits>(unitCell, enemyBuildings[leader.targetIndex]);
+        if (!leaderMoving && !inRange && u.path.empty()) return false;
+
+        u.targetIndex = leader.targetIndex;
+        u.mainTargetIndex = leader.mainTargetIndex;
+        u.breakingWall = leader.breakingWall;
+    }
+
+    u.unit->tickAttack(dt);
+    auto& tgt = enemyBuildings[u.targetIndex];
+
+    if (inAttackRangeCells<Traits>(unitCell, tgt))
+    {
+        bool finished = false;
+        if (Traits::walls == UnitWallHandling::Explode)
+        {
+            finished = (tgt.id == 10) && CombatSystem::bomberExplodeNoRange(*u.unit, u.sprite, u.wall, tgt, enemyBuildings, &_buildingIndex);
+        }
+        else if (tgt.building && tgt.sprite)
+        {
+            CombatSystem::unitHitBuildingNoRange(*u.unit, u.sprite, tgt);
+            finished = (tgt.building->hp <= 0);
+        }
+
+        if (finished)
+        {
+            u.path.clear();
+            u.pathCursor = 0;
+            u.repathCD = 0.0f;
+            u.targetIndex = -1;
+            u.mainTargetIndex = -1;
+            u.breakingWall = false;
+        }
+        return true;
+    }
+
+    // Re-sync with the leader's route whenever it was recomputed, resuming from the
+    // path cell closest to where the follower stands. No search of our own.
+    const bool samePath = !u.path.empty() && u.path.size() == leader.path.size()
+        && u.path.back().r == leader.path.back().r && u.path.back().c == leader.path.back().c;
+    if (!samePath && !leader.path.empty())
+    {
+        u.path = leader.path;
+        int best = 0;
+        int bestD = INT_MAX;
+        for (int i = 0; i < (int)u.path.size(); ++i)
+        {
+            const int d = std::max(std::abs(u.path[i].r - unitCell.r), std::abs(u.path[i].c - unitCell.c));
+            if (d <= bestD)
+            {
+                bestD = d;
+                best = i;
+            }
+        }
+        u.pathCursor = (bestD == 0) ? best + 1 : best;
+        u.repathCD = 0.35f;
+    }
+
+    stepAlongPath(u, dt, u.formationOffset);
+    return true;
+}
+
+template <typename Traits>
 void AISystem::updateOneUnit(float dt, BattleUnitRuntime& u,
     std::vector<EnemyBuildingRuntime>& enemyBuildings)
 {
@@ -725,7 +1056,7 @@ void AISystem::updateOneUnit(float dt, BattleUnitRuntime& u,
     if (_gridReady)
     {
         
-        buildBlockedMap(enemyBuildings, blockedHard, true, isGiant(*u.unit));
+        buildBlockedMap(enemyBuildings, blockedHard, true, Traits::blockedCentersOnly);
         
         auto st = worldToGrid(u.sprite->getPosition());
         int idx = st.r * _cols + st.c;
@@ -741,7 +1072,7 @@ void AISystem::updateOneUnit(float dt, BattleUnitRuntime& u,
     };
 
     
-    if (isBomber(*u.unit))
+    if (Traits::walls == UnitWallHandling::Explode)
     {
         u.breakingWall = false;
         u.mainTargetIndex = -1;
@@ -763,7 +1094,7 @@ void AISystem::updateOneUnit(float dt, BattleUnitRuntime& u,
         if (!isValidIndex(i) || e.id != 10) continue;
 
                 std::vector<Pathfinding::GridPos> path;
-                if (!buildBestPathForTarget(*u.unit, unitCell, e, blockedHard, path))
+                if (!buildBestPathForTarget<Traits>(unitCell, e, blockedHard, path))
                     continue;
 
                 int len = (int)path.size();
@@ -788,7 +1119,7 @@ void AISystem::updateOneUnit(float dt, BattleUnitRuntime& u,
             else
             {
                 
-                u.targetIndex = pickTargetIndex(*u.unit, unitCell, enemyBuildings, blockedHard);
+                u.targetIndex = pickTargetIndex<Traits>(unitCell, enemyBuildings, blockedHard);
                 u.path.clear();
                 u.pathCursor = 0;
                 u.repathCD = 0.0f;
@@ -798,9 +1129,9 @@ void AISystem::updateOneUnit(float dt, BattleUnitRuntime& u,
         if (!isValidIndex(u.targetIndex)) return;
         auto& tgt = enemyBuildings[u.targetIndex];
 
-        if (tgt.id == 10 && inAttackRangeCells(*u.unit, unitCell, tgt))
+        if (tgt.id == 10 && inAttackRangeCells<Traits>(unitCell, tgt))
         {
-            if (CombatSystem::bomberExplodeNoRange(*u.unit, u.sprite, tgt, enemyBuildings))
+            if (CombatSystem::bomberExplodeNoRange(*u.unit, u.sprite, u.wall, tgt, enemyBuildings, &_buildingIndex))
             {
                 u.path.clear();
                 u.pathCursor = 0;
@@ -813,7 +1144,7 @@ void AISystem::updateOneUnit(float dt, BattleUnitRuntime& u,
         u.repathCD -= dt;
         if (u.repathCD <= 0.0f)
         {
-            recomputePath(u, tgt, blockedHard);
+            recomputePath<Traits>(u, tgt, blockedHard);
             u.repathCD = std::max(u.repathCD, 0.05f);
         }
         stepAlongPath(u, dt);
@@ -825,7 +1156,7 @@ void AISystem::updateOneUnit(float dt, BattleUnitRuntime& u,
     {
         
         std::vector<Pathfinding::GridPos> bestPath;
-        int reachable = pickReachableTargetIndex(*u.unit, unitCell, enemyBuildings, blockedHard, &bestPath);
+        int reachable = pickReachableTargetIndex<Traits>(unitCell, enemyBuildings, blockedHard, &bestPath);
         if (reachable >= 0)
         {
             u.mainTargetIndex = reachable;
@@ -841,7 +1172,7 @@ void AISystem::updateOneUnit(float dt, BattleUnitRuntime& u,
         {
             
             
-            u.mainTargetIndex = pickTargetIndex(*u.unit, unitCell, enemyBuildings, blockedHard);
+            u.mainTargetIndex = pickTargetIndex<Traits>(unitCell, enemyBuildings, blockedHard);
             u.breakingWall = false;
             u.targetIndex = u.mainTargetIndex;
             u.path.clear();
@@ -865,7 +1196,7 @@ void AISystem::updateOneUnit(float dt, BattleUnitRuntime& u,
             
             u.breakingWall = false;
             std::vector<Pathfinding::GridPos> bestPath;
-            int reachable = pickReachableTargetIndex(*u.unit, unitCell, enemyBuildings, blockedHard, &bestPath);
+            int reachable = pickReachableTargetIndex<Traits>(unitCell, enemyBuildings, blockedHard, &bestPath);
             if (reachable >= 0)
             {
                 u.mainTargetIndex = reachable;
@@ -900,11 +1231,11 @@ void AISystem::updateOneUnit(float dt, BattleUnitRuntime& u,
     auto& tgt = enemyBuildings[curIdx];
 
     
-    if (inAttackRangeCells(*u.unit, unitCell, tgt))
+    if (inAttackRangeCells<Traits>(unitCell, tgt))
     {
         if (tgt.building && tgt.sprite)
         {
-            CombatSystem::unitHitBuildingNoRange(*u.unit, u.sprite, *tgt.building, tgt.sprite);
+            CombatSystem::unitHitBuildingNoRange(*u.unit, u.sprite, tgt);
             if (tgt.building->hp <= 0)
             {
                 u.path.clear();
@@ -922,7 +1253,7 @@ void AISystem::updateOneUnit(float dt, BattleUnitRuntime& u,
                     u.breakingWall = false;
 
                     std::vector<Pathfinding::GridPos> bestPath;
-                    int reachable = pickReachableTargetIndex(*u.unit, unitCell, enemyBuildings, blockedHard, &bestPath);
+                    int reachable = pickReachableTargetIndex<Traits>(unitCell, enemyBuildings, blockedHard, &bestPath);
                     if (reachable >= 0)
                     {
                         u.mainTargetIndex = reachable;
@@ -958,7 +1289,7 @@ void AISystem::updateOneUnit(float dt, BattleUnitRuntime& u,
         {
             
             std::vector<Pathfinding::GridPos> bestPath;
-            int reachable = pickReachableTargetIndex(*u.unit, unitCell, enemyBuildings, blockedHard, &bestPath);
+            int reachable = pickReachableTargetIndex<Traits>(unitCell, enemyBuildings, blockedHard, &bestPath);
             if (reachable >= 0)
             {
                 u.mainTargetIndex = reachable;
@@ -974,7 +1305,7 @@ void AISystem::updateOneUnit(float dt, BattleUnitRuntime& u,
             {
                 
                 if (!isValidIndex(u.mainTargetIndex))
-                    u.mainTargetIndex = pickTargetIndex(*u.unit, unitCell, enemyBuildings, blockedHard);
+                    u.mainTargetIndex = pickTargetIndex<Traits>(unitCell, enemyBuildings, blockedHard);
                 if (!isValidIndex(u.mainTargetIndex))
                 {
                     u.targetIndex = -1;
@@ -982,12 +1313,12 @@ void AISystem::updateOneUnit(float dt, BattleUnitRuntime& u,
                 }
 
                 u.targetIndex = u.mainTargetIndex;
-                recomputePath(u, enemyBuildings[u.mainTargetIndex], blockedHard);
+                recomputePath<Traits>(u, enemyBuildings[u.mainTargetIndex], blockedHard);
 
-                if (u.path.empty() && (isBarbarian(*u.unit) || isGiant(*u.unit)))
+                if (u.path.empty() && Traits::walls == UnitWallHandling::Attack)
                 {
                     Pathfinding::GridPos center = getCenterCell(enemyBuildings[u.mainTargetIndex]);
-                    int wallIdx = pickWallToBreak(*u.unit, unitCell, center, enemyBuildings, blockedHard);
+                    int wallIdx = pickWallToBreak<Traits>(unitCell, center, enemyBuildings, blockedHard);
                     if (wallIdx >= 0)
                     {
                         u.breakingWall = true;
@@ -995,7 +1326,7 @@ void AISystem::updateOneUnit(float dt, BattleUnitRuntime& u,
                         u.path.clear();
                         u.pathCursor = 0;
                         u.repathCD = 0.0f;
-                        recomputePath(u, enemyBuildings[wallIdx], blockedHard);
+                        recomputePath<Traits>(u, enemyBuildings[wallIdx], blockedHard);
                     }
                 }
 
@@ -1006,7 +1337,7 @@ void AISystem::updateOneUnit(float dt, BattleUnitRuntime& u,
         else
         {
             
-            recomputePath(u, tgt, blockedHard);
+            recomputePath<Traits>(u, tgt, blockedHard);
             if (u.path.empty()) u.repathCD = 0.60f;
         }
     }
@@ -1018,14 +1349,28 @@ void AISystem::updateDefenses(float dt,
     std::vector<BattleUnitRuntime>& units,
     std::vector<EnemyBuildingRuntime>& enemyBuildings)
 {
+    // One SoA snapshot per tick feeds every defense's vectorized range sweep; the
+    // unit hash narrows each sweep to the units near that defense.
+    const size_t n = units.size();
+    _unitPositions.x.resize(n);
+    _unitPositions.y.resize(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        const auto& u = units[i];
+        const bool targetable = u.unit && u.sprite && !u.unit->isDead();
+        const Vec2 p = targetable ? u.sprite->getPosition() : Vec2(UnitPositionsSoA::FAR_AWAY, UnitPositionsSoA::FAR_AWAY);
+        _unitPositions.x[i] = p.x;
+        _unitPositions.y[i] = p.y;
+    }
+
     for (auto& e : enemyBuildings)
     {
         if (!e.building || e.building->hp <= 0 || !e.sprite) continue;
 
         
-        if (!(e.id == 1 || e.id == 2)) continue;
+        if (e.defense.kind == DefenseStats::NONE) continue;
 
-        CombatSystem::tryDefenseShoot(dt, *e.building, e.sprite, units, e.defenseCooldown, _cellSizePx);
+        CombatSystem::tryDefenseShoot(dt, e, units, _cellSizePx, &_projectiles, &_unitPositions, &_unitHash);
     }
 }
 
@@ -1044,21 +1389,7 @@ void AISystem::cleanup(float dt,
             if (!u.dying)
             {
                 
-                switch (u.unit->unitId)
-                {
-                case 2: 
-                    SoundManager::playSfxRandom("archer_death", 1.0f);
-                    break;
-                case 3: 
-                    SoundManager::playSfxRandom("giant_death", 1.0f);
-                    break;
-                case 4: 
-                    SoundManager::playSfxRandom("wall_breaker_death", 1.0f);
-                    break;
-                default: 
-                    SoundManager::playSfxRandom("barbarian_death", 1.0f);
-                    break;
-                }
+                SoundManager::playSfxRandom(getUnitTraitsRow(u.unit->unitId).deathSfx, 1.0f);
 
                 u.dying = true;
                 u.dyingTimer = 0.30f;
@@ -1079,6 +1410,7 @@ void AISystem::cleanup(float dt,
                 if (u.dyingTimer <= 0.0f)
                 {
                     if (u.sprite) u.sprite->removeFromParent();
+                    _projectiles.forgetTarget(u.unit.get());
                     units.erase(units.begin() + i);
                 }
             }
@@ -1105,7 +1437,7 @@ void AISystem::cleanup(float dt,
                 e.sprite->setOpacity(255);
 
                 
-                e.sprite->removeChildByName("__hpbar");
+                CombatSystem::removeHpBar(e.sprite);
 
                 
                 auto tex = cocos2d::Director::getInstance()->getTextureCache()->addImage("ruin.png");
@@ -1165,10 +1497,48 @@ void AISystem::update(float dt,
 {
     if (dt <= 0.0f) return;
 
-    for (auto& u : units)
-        updateOneUnit(dt, u, enemyBuildings);
+    // Safety net in case the scene did not prepare the building table.
+    if (_gridReady && _buildingCells.size() != enemyBuildings.size())
+        prepareBuildings(enemyBuildings);
+
+    _battleTime += dt;
+    CombatLog::setTime(_battleTime);
+    updateSquadLeaders(units);
+
+    // Group by type so each group runs an update loop specialised for its traits.
+    for (auto& group : _unitsByType) group.clear();
+    for (int i = 0; i < (int)units.size(); ++i)
+    {
+        if (!units[i].unit) continue;
+        const int id = getUnitTraitsRow(units[i].unit->unitId).id;
+        _unitsByType[id].push_back(i);
+    }
+
+    // Squads never mix types and groups keep index order, so leaders still run
+    // before their followers and followers read this tick's leader path.
+    forEachUnitType([&](auto traits) {
+        using Traits = decltype(traits);
+        for (int i : _unitsByType[Traits::id])
+        {
+            auto& u = units[i];
+            const int leader = (u.squadId >= 0 && u.squadId < (int)_squadLeaders.size())
+                ? _squadLeaders[(size_t)u.squadId] : -1;
+            if (leader >= 0 && leader != i && followSquadLeader<Traits>(dt, u, units[leader], enemyBuildings))
+                continue;
+            updateOneUnit<Traits>(dt, u, enemyBuildings);
+        }
+    });
+
+    _unitHash.rebuild(units, _cellSizePx * 2.0f);
+    applySeparation(dt, units, enemyBuildings);
+
+    // Land projectiles fired on earlier ticks, then let defenses fire new ones.
+    _projectiles.update(dt);
+    for (const auto& hit : _projectiles.hits())
+        CombatSystem::resolveProjectileHit(hit);
 
     updateDefenses(dt, units, enemyBuildings);
+    _projectiles.render();
 
     cleanup(dt, units, enemyBuildings);
 }
@@ -4,10 +4,39 @@
 #include <memory>
 
 #include "GameObjects/Units/UnitBase.h"
+#include "GameObjects/Units/UnitTraits.h"
 #include "GameObjects/Buildings/Building.h"
 #include "Systems/Pathfinding.h"
+#include "Systems/UnitSpatialHash.h"
+#include "Systems/ProjectileSystem.h"
+#include "Systems/BuildingSpatialIndex.h"
 
 
+// DefenseStats caches the shooting parameters of a defense building.
+// Filled once by CombatSystem::initBuildingStats so combat never casts per frame.
+
+struct DefenseStats {
+    enum Kind { NONE = 0, ARROW_TOWER = 1, CANNON = 2 };
+    int kind = NONE;
+    float damagePerHit = 0.0f;
+    float attacksPerSecond = 0.0f;
+    int rangeCells = 0;
+};
+
+// LootStats records which resource a building holds (drives the steal sound).
+
+struct LootStats {
+    enum Resource { NONE = 0, GOLD = 1, ELIXIR = 2 };
+    int resource = NONE;
+};
+
+// WallStats caches the wall splash of a unit; filled by CombatSystem::initUnitStats.
+// The wall damage itself comes from kDamageMatrix.
+
+struct WallStats {
+    float damageRadiusTiles = 2.0f;
+};
+
 // BattleUnitRuntime encapsulates related behavior and state.
 
 
@@ -28,6 +57,14 @@ struct BattleUnitRuntime {
     int pathCursor = 0;
     float repathCD = 0.0f;
 
+    // Squad membership (-1 = moves on its own). Followers reuse the squad leader's
+    // path and keep formationOffset (world px) relative to its waypoints.
+    int squadId = -1;
+    cocos2d::Vec2 formationOffset = cocos2d::Vec2::ZERO;
+
+    
+    WallStats wall;
+
     
     bool dying = false;
     float dyingTimer = 0.0f;
@@ -47,8 +84,16 @@ struct EnemyBuildingRuntime {
     cocos2d::Sprite* sprite = nullptr;
 
     
+    DefenseStats defense;
+    LootStats loot;
+    int category = 0;  // BuildingCategory (Patterns/DamageMatrix.h)
+
+    
     float defenseCooldown = 0.0f;
 
+    // Current HexFacing of a directional defense sprite (-1 = initial art).
+    int facing = -1;
+
     
     
     bool ruinShown = false;
@@ -69,6 +114,18 @@ int lastHp = 0;
     
     bool dying = false;
     float dyingTimer = 0.0f;
+
+    // Index into AISystem's precomputed building cells table (-1 = not prepared).
+    int cellsSlot = -1;
+};
+
+// UnitPositionsSoA is a per-tick snapshot of unit positions laid out for SIMD sweeps.
+// Entry i belongs to units[i]; units that cannot be targeted sit at FAR_AWAY.
+
+struct UnitPositionsSoA {
+    static constexpr float FAR_AWAY = 1.0e18f;
+    std::vector<float> x;
+    std::vector<float> y;
 };
 
 // AISystem encapsulates related behavior and state.
@@ -84,7 +141,25 @@ public:
     void setIsoGrid(int rows, int cols, float tileW, float tileH, const cocos2d::Vec2& anchor);
 
     
-    void setCellSizePx(float cellSizePx) { _cellSizePx = cellSizePx; }
+    void setCellSizePx(float cellSizePx) { _cellSizePx = cellSizePx; _projectiles.setCellSizePx(cellSizePx); }
+
+    // Puts a freshly spawned unit into a squad with units of the same type that were
+    // deployed close by shortly before, or starts a new squad. Call before the first update.
+    void assignSquad(BattleUnitRuntime& u);
+
+    // Spatial hash of living unit positions, rebuilt every tick after movement.
+    // Shared by separation steering, defense targeting and area effects.
+    const UnitSpatialHash& unitHash() const { return _unitHash; }
+
+    // Grid-bucketed index of enemy buildings for area effects, built by prepareBuildings.
+    const BuildingSpatialIndex& buildingIndex() const { return _buildingIndex; }
+
+    // Defense projectiles in flight. Attach it to the battle world to see them.
+    ProjectileSystem& projectiles() { return _projectiles; }
+
+    // Precomputes footprint, center and approach cells of every enemy building.
+    // Call once after the enemy village is built (and after setIsoGrid).
+    void prepareBuildings(std::vector<EnemyBuildingRuntime>& enemyBuildings);
 
     
     // Updates the object state.
@@ -95,11 +170,76 @@ public:
         std::vector<EnemyBuildingRuntime>& enemyBuildings);
 
 private:
-    
-    static constexpr int UNIT_BARBARIAN = 1;
-    static constexpr int UNIT_ARCHER    = 2;
-    static constexpr int UNIT_GIANT     = 3;
-    static constexpr int UNIT_BOMBER    = 4;
+    // Unit indices grouped by type id (index 0 unused), refilled every tick.
+    std::vector<int> _unitsByType[UNIT_TYPE_COUNT + 1];
+
+    // Approach ring radius (in cells) around a building footprint.
+    static constexpr int MELEE_APPROACH_RANGE = 1;
+    static constexpr int ARCHER_APPROACH_RANGE = 3;
+
+    // Per-building distance-to-footprint window: (2R+1)^2 cells centered on the
+    // building, rows padded to 16 bytes for the SIMD transform.
+    static constexpr int DIST_RADIUS = ARCHER_APPROACH_RANGE + 1;
+    static constexpr int DIST_SIZE = DIST_RADIUS * 2 + 1;
+    static constexpr int DIST_STRIDE = 16;
+    static constexpr unsigned char DIST_FAR = 255;
+
+    // CellSpan is a read-only view into the precomputed cell pool.
+    struct CellSpan {
+        const Pathfinding::GridPos* first = nullptr;
+        int count = 0;
+        const Pathfinding::GridPos* begin() const { return first; }
+        const Pathfinding::GridPos* end() const { return first + count; }
+        bool empty() const { return count == 0; }
+    };
+
+    // BuildingCells stores the static grid geometry of one enemy building.
+    // Cell lists are ranges inside _cellPool.
+    struct BuildingCells {
+        Pathfinding::GridPos center;
+        int footRadius = 1;
+        int distBegin = 0;
+        int footBegin = 0, footCount = 0;
+        int meleeRingBegin = 0, meleeRingCount = 0;
+        int archerRingBegin = 0, archerRingCount = 0;
+    };
+
+    // Squad tuning: join window (seconds of battle time since the last join), join
+    // radius in cells, maximum size, and how far (in cells) a follower may drift
+    // from its leader before it splits off.
+    static constexpr float SQUAD_JOIN_WINDOW = 1.0f;
+    static constexpr float SQUAD_JOIN_RADIUS_CELLS = 2.0f;
+    static constexpr int SQUAD_MAX_SIZE = 16;
+    static constexpr float SQUAD_LEASH_CELLS = 3.0f;
+
+    // Squad encapsulates related behavior and state.
+    struct Squad {
+        int unitId = 0;
+        cocos2d::Vec2 anchor = cocos2d::Vec2::ZERO;
+        float lastJoinTime = 0.0f;
+        int size = 0;
+    };
+
+    // Separation steering: units closer than SEPARATION_RADIUS_CELLS push each other
+    // apart, moving at most SEPARATION_SPEED_RATIO of their walk speed.
+    static constexpr float SEPARATION_RADIUS_CELLS = 0.8f;
+    static constexpr float SEPARATION_SPEED_RATIO = 0.5f;
+
+    UnitSpatialHash _unitHash;
+    UnitPositionsSoA _unitPositions;
+    ProjectileSystem _projectiles;
+    std::vector<cocos2d::Vec2> _separationPush;
+    std::vector<unsigned char> _separationBlocked;        // footprints and walls
+    std::vector<unsigned char> _separationBlockedCenters; // centers and walls
+
+    std::vector<Squad> _squads;
+    std::vector<int> _squadLeaders;
+    float _battleTime = 0.0f;
+
+    std::vector<BuildingCells> _buildingCells;
+    BuildingSpatialIndex _buildingIndex;
+    std::vector<Pathfinding::GridPos> _cellPool;
+    std::vector<unsigned char> _distPool;
 
     
     bool _gridReady = false;
@@ -114,10 +254,6 @@ private:
     // TODO: Add a brief description.
     Pathfinding::GridPos worldToGrid(const cocos2d::Vec2& p) const;
 
-    bool isBomber(const UnitBase& u) const { return u.unitId == UNIT_BOMBER; }
-    bool isGiant(const UnitBase& u) const { return u.unitId == UNIT_GIANT; }
-    bool isBarbarian(const UnitBase& u) const { return u.unitId == UNIT_BARBARIAN; }
-    bool isArcher(const UnitBase& u) const { return u.unitId == UNIT_ARCHER; }
 
     
     
@@ -138,10 +274,15 @@ private:
 
     bool anyDefenseAlive(const std::vector<EnemyBuildingRuntime>& enemyBuildings) const;
 
+    // Returns the precomputed cells entry of a building, or nullptr if not prepared.
+    const BuildingCells* cellsOf(const EnemyBuildingRuntime& target) const;
+
+    // Computes the center cell directly from the building position.
+    Pathfinding::GridPos computeCenterCell(const EnemyBuildingRuntime& target) const;
+
     // Returns the FootprintCells.
 
-    void getFootprintCells(const EnemyBuildingRuntime& target,
-        std::vector<Pathfinding::GridPos>& out) const;
+    CellSpan getFootprintCells(const EnemyBuildingRuntime& target) const;
 
     
     // Returns the CenterCell.
@@ -149,16 +290,24 @@ private:
     
     Pathfinding::GridPos getCenterCell(const EnemyBuildingRuntime& target) const;
 
+    // Chebyshev distance from a cell to the building footprint (DIST_FAR outside the window).
+    unsigned char footprintDistance(const BuildingCells& bc, const Pathfinding::GridPos& cell) const;
+
+    // Collects passable cells whose footprint distance is <= maxDist, row-major around the center.
+    void collectCellsWithin(const BuildingCells& bc, int maxDist,
+        const std::vector<unsigned char>& blocked,
+        std::vector<Pathfinding::GridPos>& out) const;
+
     // TODO: Add a brief description.
 
-    bool inAttackRangeCells(const UnitBase& unit,
-        const Pathfinding::GridPos& unitCell,
+    template <typename Traits>
+    bool inAttackRangeCells(const Pathfinding::GridPos& unitCell,
         const EnemyBuildingRuntime& target) const;
 
     // TODO: Add a brief description.
 
-    void collectApproachCells(const UnitBase& unit,
-        const EnemyBuildingRuntime& target,
+    template <typename Traits>
+    void collectApproachCells(const EnemyBuildingRuntime& target,
         const std::vector<unsigned char>& blocked,
         std::vector<Pathfinding::GridPos>& out) const;
 
@@ -168,16 +317,16 @@ private:
 
     
     
-    int pickWallToBreak(const UnitBase& unit,
-        const Pathfinding::GridPos& unitCell,
+    template <typename Traits>
+    int pickWallToBreak(const Pathfinding::GridPos& unitCell,
         const Pathfinding::GridPos& mainTargetCenter,
         const std::vector<EnemyBuildingRuntime>& enemyBuildings,
         const std::vector<unsigned char>& blockedHard) const;
 
     // TODO: Add a brief description.
 
-    int pickTargetIndex(const UnitBase& unit,
-        const Pathfinding::GridPos& unitCell,
+    template <typename Traits>
+    int pickTargetIndex(const Pathfinding::GridPos& unitCell,
         const std::vector<EnemyBuildingRuntime>& enemyBuildings,
         const std::vector<unsigned char>& blocked) const;
 
@@ -187,8 +336,8 @@ private:
 
     
     
-    bool buildBestPathForTarget(const UnitBase& unit,
-        const Pathfinding::GridPos& start,
+    template <typename Traits>
+    bool buildBestPathForTarget(const Pathfinding::GridPos& start,
         const EnemyBuildingRuntime& target,
         const std::vector<unsigned char>& blockedHard,
         std::vector<Pathfinding::GridPos>& outPath) const;
@@ -199,14 +348,15 @@ private:
 
     
     
-    int pickReachableTargetIndex(const UnitBase& unit,
-        const Pathfinding::GridPos& unitCell,
+    template <typename Traits>
+    int pickReachableTargetIndex(const Pathfinding::GridPos& unitCell,
         const std::vector<EnemyBuildingRuntime>& enemyBuildings,
         const std::vector<unsigned char>& blockedHard,
         std::vector<Pathfinding::GridPos>* outBestPath) const;
 
     // TODO: Add a brief description.
 
+    template <typename Traits>
     void recomputePath(BattleUnitRuntime& u,
         const EnemyBuildingRuntime& target,
         const std::vector<unsigned char>& blocked);
@@ -214,10 +364,28 @@ private:
     // TODO: Add a brief description.
 
     void stepAlongPath(BattleUnitRuntime& u,
-        float dt);
+        float dt,
+        const cocos2d::Vec2& offset = cocos2d::Vec2::ZERO);
+
+    // Pushes overlapping moving units apart using only neighbouring hash cells.
+    // A push never ends in a blocked cell the unit is not already standing in.
+    void applySeparation(float dt, std::vector<BattleUnitRuntime>& units,
+        const std::vector<EnemyBuildingRuntime>& enemyBuildings);
+
+    // Refreshes _squadLeaders: the first living member of each squad leads it.
+    void updateSquadLeaders(const std::vector<BattleUnitRuntime>& units);
+
+    // Moves a follower along its leader's path. Returns false when it has to fall
+    // back to individual pathing this tick; a follower that strayed past the leash
+    // also leaves its squad (squadId = -1) for good.
+    template <typename Traits>
+    bool followSquadLeader(float dt, BattleUnitRuntime& u,
+        const BattleUnitRuntime& leader,
+        std::vector<EnemyBuildingRuntime>& enemyBuildings);
 
-    // Updates the object state.
+    // Updates the object state. Instantiated once per unit type.
 
+    template <typename Traits>
     void updateOneUnit(float dt, BattleUnitRuntime& u,
         std::vector<EnemyBuildingRuntime>& enemyBuildings);
 
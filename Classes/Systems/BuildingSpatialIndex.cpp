@@ -0,0 +1,72 @@
+// File: BuildingSpatialIndex.cpp
+// Brief: Implements the BuildingSpatialIndex component.
+#include "Systems/BuildingSpatialIndex.h"
+#include "Systems/AISystem.h"
+
+#include <algorithm>
+#include <cmath>
+
+void BuildingSpatialIndex::clear()
+{
+    _bucketRows = 0;
+    _bucketCols = 0;
+    _bucketStart.clear();
+    _entries.clear();
+}
+
+void BuildingSpatialIndex::build(const std::vector<EnemyBuildingRuntime>& enemyBuildings, int rows, int cols)
+{
+    clear();
+    if (rows <= 0 || cols <= 0) return;
+
+    _bucketRows = (rows + BUCKET_CELLS - 1) / BUCKET_CELLS;
+    _bucketCols = (cols + BUCKET_CELLS - 1) / BUCKET_CELLS;
+    const int buckets = _bucketRows * _bucketCols;
+
+    auto bucketOf = [&](const EnemyBuildingRuntime& e) {
+        const int br = std::max(0, std::min(_bucketRows - 1, e.r / BUCKET_CELLS));
+        const int bc = std::max(0, std::min(_bucketCols - 1, e.c / BUCKET_CELLS));
+        return br * _bucketCols + bc;
+    };
+
+    // Count, prefix-sum, scatter.
+    _bucketStart.assign((size_t)buckets + 1, 0);
+    int total = 0;
+    for (const auto& e : enemyBuildings)
+    {
+        if (!e.building) continue;
+        ++_bucketStart[(size_t)bucketOf(e) + 1];
+        ++total;
+    }
+    for (int b = 0; b < buckets; ++b)
+        _bucketStart[(size_t)b + 1] += _bucketStart[(size_t)b];
+
+    _entries.resize((size_t)total);
+    std::vector<int> fill(_bucketStart.begin(), _bucketStart.end() - 1);
+    for (int i = 0; i < (int)enemyBuildings.size(); ++i)
+    {
+        const auto& e = enemyBuildings[(size_t)i];
+        if (!e.building) continue;
+        Entry& out = _entries[(size_t)fill[(size_t)bucketOf(e)]++];
+        out.index = i;
+        out.r = e.r;
+        out.c = e.c;
+        out.id = e.id;
+    }
+}
+
+void BuildingSpatialIndex::queryRadius(float r, float c, float radiusCells, int typeId, std::vector<int>& out) const
+{
+    out.clear();
+    forEachInRadius(r, c, radiusCells, typeId, [&](int index, float) { out.push_back(index); });
+}
+
+void BuildingSpatialIndex::bucketRange(float r, float c, float radiusCells,
+    int& br0, int& bc0, int& br1, int& bc1) const
+{
+    const float inv = 1.0f / (float)BUCKET_CELLS;
+    br0 = std::max(0, (int)std::floor((r - radiusCells) * inv));
+    bc0 = std::max(0, (int)std::floor((c - radiusCells) * inv));
+    br1 = std::min(_bucketRows - 1, (int)std::floor((r + radiusCells) * inv));
+    bc1 = std::min(_bucketCols - 1, (int)std::floor((c + radiusCells) * inv));
+}
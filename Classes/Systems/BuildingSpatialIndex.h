@@ -0,0 +1,79 @@
+// File: BuildingSpatialIndex.h
+// Brief: Declares the BuildingSpatialIndex component.
+#pragma once
+#include <cstddef>
+#include <vector>
+
+struct EnemyBuildingRuntime;
+
+// BuildingSpatialIndex buckets enemy buildings by grid cell for area queries.
+//
+// Buildings never move during a battle, so the index is built once (counting sort
+// into BUCKET_CELLS x BUCKET_CELLS buckets). Radius queries only scan the buckets
+// overlapping the query circle and compare squared grid distances, optionally
+// filtered by building id. Splash damage and spells should use it instead of
+// looping over every building.
+
+class BuildingSpatialIndex {
+public:
+    static constexpr int BUCKET_CELLS = 4;
+
+    // Indexes every building that has a runtime building, by its (r, c) cell.
+    void build(const std::vector<EnemyBuildingRuntime>& enemyBuildings, int rows, int cols);
+
+    // Clears all buckets.
+    void clear();
+
+    // Returns whether Empty is true.
+    bool empty() const { return _entries.empty(); }
+
+    // Calls fn(buildingIndex, distSqCells) for every indexed building whose cell lies
+    // within radiusCells of (r, c). typeId != 0 keeps only buildings with that id.
+    // Liveness is not checked; callers skip destroyed buildings themselves.
+    template <typename Fn>
+    void forEachInRadius(float r, float c, float radiusCells, int typeId, Fn&& fn) const
+    {
+        if (_entries.empty() || radiusCells < 0.0f) return;
+
+        int br0, bc0, br1, bc1;
+        bucketRange(r, c, radiusCells, br0, bc0, br1, bc1);
+        const float r2 = radiusCells * radiusCells;
+
+        for (int br = br0; br <= br1; ++br)
+        {
+            for (int bc = bc0; bc <= bc1; ++bc)
+            {
+                const int bucket = br * _bucketCols + bc;
+                for (int k = _bucketStart[(size_t)bucket]; k < _bucketStart[(size_t)bucket + 1]; ++k)
+                {
+                    const Entry& e = _entries[(size_t)k];
+                    if (typeId != 0 && e.id != typeId) continue;
+                    const float dr = (float)e.r - r;
+                    const float dc = (float)e.c - c;
+                    const float d2 = dr * dr + dc * dc;
+                    if (d2 <= r2) fn(e.index, d2);
+                }
+            }
+        }
+    }
+
+    // Collects the indices found by forEachInRadius into out (cleared first).
+    void queryRadius(float r, float c, float radiusCells, int typeId, std::vector<int>& out) const;
+
+private:
+    // Entry is one indexed building.
+    struct Entry {
+        int index;
+        int r, c;
+        int id;
+    };
+
+    // Clamped bucket rectangle overlapped by the query circle (inclusive).
+    void bucketRange(float r, float c, float radiusCells,
+        int& br0, int& bc0, int& br1, int& bc1) const;
+
+    int _bucketRows = 0;
+    int _bucketCols = 0;
+    std::vector<int> _bucketStart;   // buckets + 1 prefix offsets into _entries
+    std::vector<Entry> _entries;     // grouped by bucket
+};
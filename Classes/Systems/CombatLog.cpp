@@ -0,0 +1,172 @@
+// File: CombatLog.cpp
+// Brief: Implements the CombatLog component.
+#include "Systems/CombatLog.h"
+
+#include "Data/SaveWorker.h"
+
+#include "cocos2d.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+using namespace cocos2d;
+
+namespace {
+
+// Ring capacity (power of two). 16K events cover several seconds of a large battle
+// even if the writer thread is descheduled.
+const uint32_t kRingCapacity = 1u << 14;
+const uint32_t kRingMask = kRingCapacity - 1;
+
+// How long the writer sleeps when the ring is empty.
+const int kDrainIntervalMs = 20;
+
+const char* const kEnabledKey = "combat_log";
+#if defined(COCOS2D_DEBUG) && COCOS2D_DEBUG > 0
+const bool kEnabledByDefault = true;
+#else
+const bool kEnabledByDefault = false;
+#endif
+
+// LogSession holds the ring and the writer thread of the current battle.
+struct LogSession {
+    CombatEvent ring[kRingCapacity];
+    std::atomic<uint32_t> head{ 0 };    // next slot to write (producer)
+    std::atomic<uint32_t> tail{ 0 };    // next slot to read (consumer)
+    std::atomic<bool> stop{ false };
+    uint32_t dropped = 0;               // producer only
+    bool active = false;                // producer only
+    float time = 0.0f;                  // producer only
+
+    std::FILE* file = nullptr;
+    std::thread writer;
+
+    ~LogSession()
+    {
+        // Never let a joinable thread reach std::thread's destructor at exit.
+        if (writer.joinable())
+        {
+            stop.store(true, std::memory_order_release);
+            writer.join();
+        }
+    }
+};
+
+LogSession s_log;
+
+// Writes every event currently in the ring. Consumer side only.
+void drainRing()
+{
+    uint32_t t = s_log.tail.load(std::memory_order_relaxed);
+    const uint32_t h = s_log.head.load(std::memory_order_acquire);
+    while (t != h)
+    {
+        const CombatEvent& e = s_log.ring[t & kRingMask];
+        std::fprintf(s_log.file, "%.3f,%u,%u,%d,%d,%d,%d\n",
+            e.time, (unsigned)e.kind, (unsigned)e.unitType,
+            (int)e.buildingId, (int)e.buildingIndex, (int)e.damage, (int)e.overkill);
+        ++t;
+    }
+    s_log.tail.store(t, std::memory_order_release);
+}
+
+void writerLoop()
+{
+    while (!s_log.stop.load(std::memory_order_acquire))
+    {
+        drainRing();
+        std::this_thread::sleep_for(std::chrono::milliseconds(kDrainIntervalMs));
+    }
+    // The producer has stopped; whatever is left is final.
+    drainRing();
+    std::fflush(s_log.file);
+}
+
+}  // namespace
+
+bool CombatLog::isEnabled()
+{
+    return UserDefault::getInstance()->getBoolForKey(kEnabledKey, kEnabledByDefault);
+}
+
+void CombatLog::setEnabled(bool enabled)
+{
+    UserDefault::getInstance()->setBoolForKey(kEnabledKey, enabled);
+    UserDefault::getInstance()->flush();
+}
+
+bool CombatLog::begin(const std::string& path)
+{
+    end();
+
+    s_log.file = SaveWorker::openFile(path, "wb");
+    if (!s_log.file) return false;
+    std::fputs("time,kind,unit_type,building_id,building_index,damage,overkill\n", s_log.file);
+
+    s_log.head.store(0, std::memory_order_relaxed);
+    s_log.tail.store(0, std::memory_order_relaxed);
+    s_log.stop.store(false, std::memory_order_relaxed);
+    s_log.dropped = 0;
+    s_log.time = 0.0f;
+    s_log.writer = std::thread(writerLoop);
+    s_log.active = true;
+    return true;
+}
+
+void CombatLog::end()
+{
+    if (!s_log.active) return;
+    s_log.active = false;
+
+    s_log.stop.store(true, std::memory_order_release);
+    if (s_log.writer.joinable()) s_log.writer.join();
+
+    if (s_log.dropped > 0)
+        std::fprintf(s_log.file, "# dropped,%u\n", s_log.dropped);
+    std::fclose(s_log.file);
+    s_log.file = nullptr;
+}
+
+bool CombatLog::isActive()
+{
+    return s_log.active;
+}
+
+void CombatLog::setTime(float battleTime)
+{
+    s_log.time = battleTime;
+}
+
+void CombatLog::record(CombatEventKind kind, int unitType, int buildingId, int buildingIndex,
+    int damage, int overkill)
+{
+    if (!s_log.active) return;
+
+    const uint32_t h = s_log.head.load(std::memory_order_relaxed);
+    const uint32_t t = s_log.tail.load(std::memory_order_acquire);
+    if (h - t >= kRingCapacity)
+    {
+        ++s_log.dropped;
+        return;
+    }
+
+    CombatEvent& e = s_log.ring[h & kRingMask];
+    e.time = s_log.time;
+    e.kind = (uint8_t)kind;
+    e.unitType = (uint8_t)unitType;
+    e.buildingId = (int16_t)buildingId;
+    e.buildingIndex = (int16_t)buildingIndex;
+    e.damage = damage;
+    e.overkill = overkill;
+    s_log.head.store(h + 1, std::memory_order_release);
+}
+
+std::string CombatLog::defaultPath()
+{
+    auto fu = FileUtils::getInstance();
+    std::string dir = fu->getWritablePath() + "battle_logs/";
+    if (!fu->isDirectoryExist(dir)) fu->createDirectory(dir);
+    return dir + "last_battle.csv";
+}
@@ -0,0 +1,62 @@
+// File: CombatLog.h
+// Brief: Declares the CombatLog component.
+#pragma once
+#include <cstdint>
+#include <string>
+
+// What a CombatEvent describes.
+enum CombatEventKind : uint8_t {
+    COMBAT_UNIT_HIT_BUILDING = 1,   // a unit (or its splash) damaged a building
+    COMBAT_DEFENSE_HIT_UNIT = 2,    // a defense damaged a unit
+    COMBAT_BUILDING_DESTROYED = 3,  // a building reached 0 hp
+    COMBAT_UNIT_KILLED = 4,         // a unit reached 0 hp
+};
+
+// CombatEvent is one compact, trivially copyable analytics record.
+struct CombatEvent {
+    float time;              // battle time in seconds
+    uint8_t kind;            // CombatEventKind
+    uint8_t unitType;        // unit id of the attacker / victim (0 = none)
+    int16_t buildingId;      // building type id (0 = none)
+    int16_t buildingIndex;   // building save index (-1 = none)
+    int32_t damage;          // damage actually removed from hp
+    int32_t overkill;        // damage beyond the remaining hp
+};
+
+// CombatLog records combat events of one battle for offline analytics.
+//
+// Combat code calls record(), which copies the event into a fixed-size single-
+// producer/single-consumer ring (no locks, no allocation; the event is dropped and
+// counted if the ring is full). A background thread drains the ring into a CSV file
+// and end() flushes the rest when the battle is over. While no battle is being
+// logged record() returns after one flag check.
+// Logging is opt-in: battles only call begin() when isEnabled() is set.
+
+class CombatLog {
+public:
+    // Returns whether battles should be logged: the "combat_log" UserDefault key,
+    // which defaults to on in debug builds and off otherwise.
+    static bool isEnabled();
+
+    // Stores the "combat_log" switch.
+    static void setEnabled(bool enabled);
+
+    // Starts logging into path (truncated). Ends a previous session first.
+    static bool begin(const std::string& path);
+
+    // Stops the writer thread after draining every pending event. Safe to call twice.
+    static void end();
+
+    // Returns whether Active is true.
+    static bool isActive();
+
+    // Sets the battle time stamped on subsequent events (call once per tick).
+    static void setTime(float battleTime);
+
+    // Appends an event (main thread only).
+    static void record(CombatEventKind kind, int unitType, int buildingId, int buildingIndex,
+        int damage, int overkill);
+
+    // Default log file: <writable path>/battle_logs/last_battle.csv.
+    static std::string defaultPath();
+};
@@ -1,125 +1,224 @@
 // File: CombatSystem.cpp
 // Brief: Implements the CombatSystem component.
 #include "Systems/CombatSystem.h"
+#include "Systems/CombatLog.h"
+#include "Systems/DirectionalFrames.h"
 
 #include "Patterns/AttackVisitor.h"
 #include "GameObjects/Buildings/DefenseBuilding.h"
 #include "GameObjects/Buildings/ResourceBuilding.h"
 #include "GameObjects/Units/wall_breaker.h"
+#include "GameObjects/Units/UnitTraits.h"
 #include "Managers/SoundManager.h"
+#include "UI/DamageNumberLayer.h"
+#include "UI/HpBarLayer.h"
 
 #include <algorithm>
+#include <cfloat>
 #include <cmath>
 #include <string>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define COC_COMBAT_AVX2 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define COC_COMBAT_SSE2 1
+#endif
+
 using namespace cocos2d;
 
-namespace {
+// Directional cannon art, in HexFacing order. Loaded once per battle by
+// prepareDefenseVisuals so a shot only swaps a frame pointer.
+static const char* const kCannonFacingPaths[HEX_FACING_COUNT] = {
+    "cannon/cannon_north.png",
+    "cannon/cannon_northeast.png",
+    "cannon/cannon_southeast.png",
+    "cannon/cannon_south.png",
+    "cannon/cannon_southwest.png",
+    "cannon/cannon_northwest.png",
+};
+
+static DirectionalFrames s_cannonFrames;
 
-/**
- * Computes the best-matching cannon barrel sprite for the current target direction.
- *
- * The project provides 6 directional cannon sprites (N, NE, SE, S, SW, NW). We approximate
- * the direction by the angle from the cannon center to the target, then snap it to the
- * closest 60-degree sector.
- */
-std::string GetCannonFacingTexturePath(const Vec2& cannonPos, const Vec2& targetPos)
+void CombatSystem::prepareDefenseVisuals(const Size& cannonBox)
 {
-    const float dx = targetPos.x - cannonPos.x;
-    const float dy = targetPos.y - cannonPos.y;
+    s_cannonFrames.load(kCannonFacingPaths, HEX_FACING_COUNT, cannonBox);
+}
 
-    // Avoid unstable facing when both positions are extremely close.
-    if (std::abs(dx) < 0.001f && std::abs(dy) < 0.001f)
+// Scratch for tryDefenseShoot: hash candidates and their compacted positions.
+static std::vector<int> s_targetCandidates;
+static std::vector<float> s_targetX;
+static std::vector<float> s_targetY;
+
+static void playUnitHitSfx(const UnitBase& attacker, const LootStats& targetLoot)
+{
+    
+    if (targetLoot.resource == LootStats::GOLD)
     {
-        return "cannon/cannon_south.png";
+        SoundManager::playSfxRandom("coin_steal", 1.0f);
+        return;
+    }
+    if (targetLoot.resource == LootStats::ELIXIR)
+    {
+        SoundManager::playSfxRandom("elixir_steal", 1.0f);
+        return;
     }
 
-    const float rad = std::atan2(dy, dx);
-    const float deg = rad * 57.2957795f;  // [-180, 180]
-
-    // Sector centers: N(90), NE(30-60), SE(-30), S(-90), SW(-150), NW(150).
-    if (deg >= 60.0f && deg < 120.0f) return "cannon/cannon_north.png";
-    if (deg >= 0.0f && deg < 60.0f)   return "cannon/cannon_northeast.png";
-    if (deg >= -60.0f && deg < 0.0f)  return "cannon/cannon_southeast.png";
-    if (deg >= -120.0f && deg < -60.0f) return "cannon/cannon_south.png";
-    if (deg >= -180.0f && deg < -120.0f) return "cannon/cannon_southwest.png";
-    // deg in [120, 180]
-    return "cannon/cannon_northwest.png";
+    SoundManager::playSfxRandom(getUnitTraitsRow(attacker.unitId).hitSfx, 1.0f);
 }
 
-/**
- * Updates the cannon sprite texture to match the target direction.
- *
- * Note: We preserve the node's position and anchor. We may adjust its scale to keep the
- * cannon constrained to a consistent on-screen footprint when different facing textures
- * have different source pixel sizes.
- */
-void UpdateCannonFacingSprite(Sprite* cannonSprite, const Vec2& cannonPos, const Vec2& targetPos)
+void CombatSystem::initBuildingStats(EnemyBuildingRuntime& e)
 {
-    if (!cannonSprite) return;
-
-    // Preserve the current on-screen size of the cannon before swapping textures.
-    // The directional cannon textures may have different raw pixel dimensions, and
-    // without this, the cannon would visually "grow" or "shrink" when its facing
-    // changes.
-    const Size oldWorldSize = cannonSprite->getBoundingBox().size;
-
-    const std::string texPath = GetCannonFacingTexturePath(cannonPos, targetPos);
-    auto* tex = Director::getInstance()->getTextureCache()->addImage(texPath);
-    if (!tex) return;
+    e.defense = DefenseStats();
+    e.loot = LootStats();
+    e.category = buildingCategoryOf(e.id);
+    if (!e.building) return;
 
-    cannonSprite->setTexture(tex);
-    const Size ts = tex->getContentSize();
-    cannonSprite->setTextureRect(Rect(0, 0, ts.width, ts.height));
-
-    // Re-apply a scale so the sprite remains bounded by the same world-space box.
-    // We keep aspect ratio to avoid stretching the art.
-    if (ts.width > 0.0f && ts.height > 0.0f && oldWorldSize.width > 0.0f && oldWorldSize.height > 0.0f)
+    Building* b = e.building.get();
+    if (auto t = dynamic_cast<ArrowTower*>(b))
+    {
+        e.defense.kind = DefenseStats::ARROW_TOWER;
+        e.defense.damagePerHit = t->damagePerHit;
+        e.defense.attacksPerSecond = t->attacksPerSecond;
+        e.defense.rangeCells = t->rangeCells;
+    }
+    else if (auto c = dynamic_cast<Cannon*>(b))
+    {
+        e.defense.kind = DefenseStats::CANNON;
+        e.defense.damagePerHit = c->damagePerHit;
+        e.defense.attacksPerSecond = c->attacksPerSecond;
+        e.defense.rangeCells = c->rangeCells;
+    }
+    else if (dynamic_cast<GoldMine*>(b) || dynamic_cast<GoldStorage*>(b))
+    {
+        e.loot.resource = LootStats::GOLD;
+    }
+    else if (dynamic_cast<ElixirCollector*>(b) || dynamic_cast<ElixirStorage*>(b))
     {
-        const float sx = oldWorldSize.width / ts.width;
-        const float sy = oldWorldSize.height / ts.height;
-        const float s = std::min(sx, sy);
-        cannonSprite->setScale(std::max(0.0001f, s));
+        e.loot.resource = LootStats::ELIXIR;
     }
 }
 
-}  // namespace
+void CombatSystem::initUnitStats(BattleUnitRuntime& u)
+{
+    u.wall = WallStats();
+    if (const WallBreaker* wb = dynamic_cast<const WallBreaker*>(u.unit.get()))
+    {
+        u.wall.damageRadiusTiles = wb->damageRadiusTiles;
+    }
+}
 
-static void playUnitHitSfx(const UnitBase& attacker, const Building& target)
+int CombatSystem::nearestInRange(const float* xs, const float* ys, int count,
+    float cx, float cy, float range)
 {
-    
-    if (dynamic_cast<const GoldMine*>(&target) || dynamic_cast<const GoldStorage*>(&target))
+    if (!xs || !ys || count <= 0 || range < 0.0f) return -1;
+
+    const float r2 = range * range;
+    float bestD = FLT_MAX;
+    int best = -1;
+    int i = 0;
+
+#if defined(COC_COMBAT_AVX2)
     {
-        SoundManager::playSfxRandom("coin_steal", 1.0f);
-        return;
+        // Per lane: the smallest in-range d2 seen so far and the index it came from.
+        // Strict < keeps the lowest index per lane; the reduction breaks cross-lane ties.
+        const __m256 vcx = _mm256_set1_ps(cx);
+        const __m256 vcy = _mm256_set1_ps(cy);
+        const __m256 vr2 = _mm256_set1_ps(r2);
+        const __m256 vinf = _mm256_set1_ps(FLT_MAX);
+        __m256 vbest = vinf;
+        __m256i vbestI = _mm256_set1_epi32(-1);
+        __m256i vidx = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        const __m256i vstep = _mm256_set1_epi32(8);
+
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(xs + i), vcx);
+            const __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(ys + i), vcy);
+            const __m256 d2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+            const __m256 inRange = _mm256_cmp_ps(d2, vr2, _CMP_LE_OQ);
+            const __m256 cand = _mm256_blendv_ps(vinf, d2, inRange);
+            const __m256 better = _mm256_cmp_ps(cand, vbest, _CMP_LT_OQ);
+            vbest = _mm256_blendv_ps(vbest, cand, better);
+            vbestI = _mm256_castps_si256(_mm256_blendv_ps(
+                _mm256_castsi256_ps(vbestI), _mm256_castsi256_ps(vidx), better));
+            vidx = _mm256_add_epi32(vidx, vstep);
+        }
+
+        alignas(32) float lanesD[8];
+        alignas(32) int lanesI[8];
+        _mm256_store_ps(lanesD, vbest);
+        _mm256_store_si256((__m256i*)lanesI, vbestI);
+        for (int k = 0; k < 8; ++k)
+        {
+            if (lanesI[k] < 0) continue;
+            if (lanesD[k] < bestD || (lanesD[k] == bestD && lanesI[k] < best))
+            {
+                bestD = lanesD[k];
+                best = lanesI[k];
+            }
+        }
     }
-    if (dynamic_cast<const ElixirCollector*>(&target) || dynamic_cast<const ElixirStorage*>(&target))
+#elif defined(COC_COMBAT_SSE2)
     {
-        SoundManager::playSfxRandom("elixir_steal", 1.0f);
-        return;
+        // SSE2 has no blendv; select with and/andnot/or.
+        const __m128 vcx = _mm_set1_ps(cx);
+        const __m128 vcy = _mm_set1_ps(cy);
+        const __m128 vr2 = _mm_set1_ps(r2);
+        const __m128 vinf = _mm_set1_ps(FLT_MAX);
+        __m128 vbest = vinf;
+        __m128i vbestI = _mm_set1_epi32(-1);
+        __m128i vidx = _mm_setr_epi32(0, 1, 2, 3);
+        const __m128i vstep = _mm_set1_epi32(4);
+
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128 dx = _mm_sub_ps(_mm_loadu_ps(xs + i), vcx);
+            const __m128 dy = _mm_sub_ps(_mm_loadu_ps(ys + i), vcy);
+            const __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+            const __m128 inRange = _mm_cmple_ps(d2, vr2);
+            const __m128 cand = _mm_or_ps(_mm_and_ps(inRange, d2), _mm_andnot_ps(inRange, vinf));
+            const __m128 better = _mm_cmplt_ps(cand, vbest);
+            const __m128i betterI = _mm_castps_si128(better);
+            vbest = _mm_or_ps(_mm_and_ps(better, cand), _mm_andnot_ps(better, vbest));
+            vbestI = _mm_or_si128(_mm_and_si128(betterI, vidx), _mm_andnot_si128(betterI, vbestI));
+            vidx = _mm_add_epi32(vidx, vstep);
+        }
+
+        alignas(16) float lanesD[4];
+        alignas(16) int lanesI[4];
+        _mm_store_ps(lanesD, vbest);
+        _mm_store_si128((__m128i*)lanesI, vbestI);
+        for (int k = 0; k < 4; ++k)
+        {
+            if (lanesI[k] < 0) continue;
+            if (lanesD[k] < bestD || (lanesD[k] == bestD && lanesI[k] < best))
+            {
+                bestD = lanesD[k];
+                best = lanesI[k];
+            }
+        }
     }
+#endif
 
-    switch (attacker.unitId)
+    // Scalar tail (and the whole array without SIMD). Indices here are all higher,
+    // so a tie never replaces the current best.
+    for (; i < count; ++i)
     {
-    case 2: 
-        SoundManager::playSfxRandom("arrow_hit", 1.0f);
-        break;
-    case 3: 
-        SoundManager::playSfxRandom("giant_attack", 1.0f);
-        break;
-    case 4: 
-        SoundManager::playSfxRandom("wall_breaker_attack", 1.0f);
-        break;
-    default: 
-        SoundManager::playSfxRandom("barbarian_hit_stuff", 1.0f);
-        break;
+        const float dx = xs[i] - cx;
+        const float dy = ys[i] - cy;
+        const float d2 = dx * dx + dy * dy;
+        if (d2 <= r2 && d2 < bestD)
+        {
+            bestD = d2;
+            best = i;
+        }
     }
+    return best;
 }
 
-static const char* HPBAR_NAME = "__hpbar";
-static const char* HPFILL_NAME = "__hpfill";
-static const char* HPBG_NAME = "__hpbg";
-
 bool CombatSystem::isInRange(const Vec2& a, const Vec2& b, float range)
 {
     return a.distance(b) <= range;
@@ -143,6 +242,15 @@ static void punchScale(Sprite* s, int tag)
 static void showDamage(Node* parent, const Vec2& pos, int dmg)
 {
     if (!parent) return;
+
+    // The battle's pooled layer handles it when it shares the target's parent.
+    DamageNumberLayer* layer = DamageNumberLayer::current();
+    if (layer && layer->getParent() == parent)
+    {
+        layer->show(pos, dmg);
+        return;
+    }
+
     auto lab = Label::createWithSystemFont(StringUtils::format("-%d", dmg), "Arial", 20);
     if (!lab) return;
     lab->setPosition(pos + Vec2(0, 16));
@@ -161,87 +269,116 @@ static void showDamage(Node* parent, const Vec2& pos, int dmg)
     lab->runAction(act);
 }
 
-void CombatSystem::ensureHpBar(Sprite* sprite, int hp, int hpMax, bool isUnit)
-{
-    if (!sprite) return;
-    if (hpMax <= 0) hpMax = 1;
-    if (hp < 0) hp = 0;
-    if (hp > hpMax) hp = hpMax;
-
-    Node* bar = sprite->getChildByName(HPBAR_NAME);
-    LayerColor* bg = nullptr;
-    LayerColor* fill = nullptr;
+static const char* HPBAR_NAME = "__hpbar";
+static const char* HPFILL_NAME = "__hpfill";
 
-    
+// Per-sprite bar, used when no batched layer shares the sprite's parent.
+static void showSpriteHpBar(Sprite* sprite, float pct, bool isUnit)
+{
     const float w = isUnit ? 40.0f : 48.0f;
     const float h = 5.0f;
     const float pad = 1.0f;
 
-    
-    Vec2 ap = sprite->getAnchorPointInPoints();          
-    float gapUnder = 7.0f;                               
-    float yUnit = ap.y - (h * 0.5f + gapUnder);          
-    float yBuilding = sprite->getContentSize().height + 12.0f; 
+    Vec2 ap = sprite->getAnchorPointInPoints();
+    float yUnit = ap.y - (h * 0.5f + 7.0f);
+    float yBuilding = sprite->getContentSize().height + 12.0f;
 
+    Node* bar = sprite->getChildByName(HPBAR_NAME);
     if (!bar)
     {
         bar = Node::create();
         bar->setName(HPBAR_NAME);
-
-        
-        float sx = std::max(0.001f, sprite->getScaleX());
-        float sy = std::max(0.001f, sprite->getScaleY());
-        bar->setScaleX(1.0f / sx);
-        bar->setScaleY(1.0f / sy);
-
-        
-        bar->setPosition(Vec2(std::round(ap.x), std::round(isUnit ? yUnit : yBuilding)));
+        bar->setScaleX(1.0f / std::max(0.001f, sprite->getScaleX()));
+        bar->setScaleY(1.0f / std::max(0.001f, sprite->getScaleY()));
         sprite->addChild(bar, 999);
 
-        bg = LayerColor::create(Color4B(0, 0, 0, 160), w, h);
-        bg->setName(HPBG_NAME);
+        auto bg = LayerColor::create(Color4B(0, 0, 0, 160), w, h);
         bg->setIgnoreAnchorPointForPosition(false);
         bg->setAnchorPoint(Vec2(0.5f, 0.5f));
-        bg->setPosition(Vec2(0, 0));
         bar->addChild(bg);
 
-        float fw = std::max(1.0f, w - pad * 2.0f);
-        float fh = std::max(1.0f, h - pad * 2.0f);
-        fill = LayerColor::create(Color4B(60, 220, 90, 220), fw, fh);
+        auto fill = LayerColor::create(Color4B(60, 220, 90, 220),
+            std::max(1.0f, w - pad * 2.0f), std::max(1.0f, h - pad * 2.0f));
         fill->setName(HPFILL_NAME);
         fill->setIgnoreAnchorPointForPosition(false);
         fill->setAnchorPoint(Vec2(0.0f, 0.5f));
         fill->setPosition(Vec2(-w * 0.5f + pad, 0));
         bar->addChild(fill);
     }
-    else
-    {
-        
-        bar->setPosition(Vec2(std::round(ap.x), std::round(isUnit ? yUnit : yBuilding)));
+    bar->setPosition(Vec2(std::round(ap.x), std::round(isUnit ? yUnit : yBuilding)));
 
-        bg = dynamic_cast<LayerColor*>(bar->getChildByName(HPBG_NAME));
-        fill = dynamic_cast<LayerColor*>(bar->getChildByName(HPFILL_NAME));
+    if (Node* fill = bar->getChildByName(HPFILL_NAME)) fill->setScaleX(pct);
+    bar->setVisible(isUnit || pct < 0.999f);
+}
+
+void CombatSystem::ensureHpBar(Sprite* sprite, int hp, int hpMax, bool isUnit)
+{
+    if (!sprite) return;
+    if (hpMax <= 0) hpMax = 1;
+    if (hp < 0) hp = 0;
+    if (hp > hpMax) hp = hpMax;
+    const float pct = (float)hp / (float)hpMax;
+
+    // The battle's batched layer draws the bar when it shares the sprite's parent.
+    HpBarLayer* layer = HpBarLayer::current();
+    if (layer && layer->getParent() == sprite->getParent())
+    {
+        layer->setBar(sprite, pct, isUnit ? HpBarLayer::Style::Unit : HpBarLayer::Style::Building);
+        return;
     }
 
-    if (!fill) return;
+    showSpriteHpBar(sprite, pct, isUnit);
+}
+
+void CombatSystem::removeHpBar(Sprite* sprite)
+{
+    if (HpBarLayer* layer = HpBarLayer::current()) layer->removeBar(sprite);
+    if (sprite) sprite->removeChildByName(HPBAR_NAME);
+}
 
-    float pct = (float)hp / (float)hpMax;
-    pct = std::max(0.0f, std::min(1.0f, pct));
-    fill->setScaleX(pct);
 
-    
-    if (!isUnit) bar->setVisible(pct < 0.999f);
-    else bar->setVisible(true);
+// Removes dmg hp from a building and records the hit in the combat log.
+static void damageBuilding(EnemyBuildingRuntime& e, int dmg, int unitType)
+{
+    const int before = e.building->hp;
+    e.building->hp = std::max(0, before - dmg);
+
+    if (!CombatLog::isActive()) return;
+    const int applied = before - e.building->hp;
+    CombatLog::record(COMBAT_UNIT_HIT_BUILDING, unitType, e.id, e.saveIndex, applied, dmg - applied);
+    if (before > 0 && e.building->hp == 0)
+        CombatLog::record(COMBAT_BUILDING_DESTROYED, unitType, e.id, e.saveIndex, 0, 0);
 }
 
+// Kills a wall breaker that blew itself up on a wall and records the kill.
+static void killBomber(UnitBase& bomber, const EnemyBuildingRuntime& wall)
+{
+    const int before = bomber.hp;
+    bomber.hp = 0;
+    if (before > 0 && CombatLog::isActive())
+        CombatLog::record(COMBAT_UNIT_KILLED, bomber.unitId, wall.id, wall.saveIndex, 0, 0);
+}
+
+// Removes dmg hp from a unit and records the hit in the combat log.
+static void damageUnit(UnitBase& u, int dmg, int buildingId, int buildingIndex)
+{
+    const int before = u.hp;
+    u.takeDamage(dmg);
+
+    if (!CombatLog::isActive()) return;
+    const int applied = before - u.hp;
+    CombatLog::record(COMBAT_DEFENSE_HIT_UNIT, u.unitId, buildingId, buildingIndex, applied, dmg - applied);
+    if (before > 0 && u.hp == 0)
+        CombatLog::record(COMBAT_UNIT_KILLED, u.unitId, buildingId, buildingIndex, 0, 0);
+}
 
 bool CombatSystem::tryUnitAttackBuilding(UnitBase& attacker,
     Sprite* attackerSprite,
-    Building& target,
-    Sprite* targetSprite)
+    EnemyBuildingRuntime& target)
 {
-    if (!attackerSprite || !targetSprite) return false;
-    if (attacker.isDead() || target.hp <= 0) return false;
+    Sprite* targetSprite = target.sprite;
+    if (!attackerSprite || !targetSprite || !target.building) return false;
+    if (attacker.isDead() || target.building->hp <= 0) return false;
 
     if (!attacker.canAttack()) return false;
 
@@ -252,17 +389,16 @@ bool CombatSystem::tryUnitAttackBuilding(UnitBase& attacker,
         return false;
 
     
-    playUnitHitSfx(attacker, target);
+    playUnitHitSfx(attacker, target.loot);
 
-    int dmg = AttackVisitor::computeDamage(attacker, target);
-    target.hp -= dmg;
-    if (target.hp < 0) target.hp = 0;
+    int dmg = AttackVisitor::computeDamage(attacker, target.category);
+    damageBuilding(target, dmg, attacker.unitId);
 
     attacker.startAttackCooldown();
 
     
     punchScale(targetSprite, 12345);
-    ensureHpBar(targetSprite, target.hp, target.hpMax, false);
+    ensureHpBar(targetSprite, target.building->hp, target.building->hpMax, false);
     showDamage(targetSprite->getParent(), tp, dmg);
 
     return true;
@@ -270,34 +406,75 @@ bool CombatSystem::tryUnitAttackBuilding(UnitBase& attacker,
 
 bool CombatSystem::unitHitBuildingNoRange(UnitBase& attacker,
     Sprite* attackerSprite,
-    Building& target,
-    Sprite* targetSprite)
+    EnemyBuildingRuntime& target)
 {
-    if (!attackerSprite || !targetSprite) return false;
-    if (attacker.isDead() || target.hp <= 0) return false;
+    Sprite* targetSprite = target.sprite;
+    if (!attackerSprite || !targetSprite || !target.building) return false;
+    if (attacker.isDead() || target.building->hp <= 0) return false;
     if (!attacker.canAttack()) return false;
 
     Vec2 tp = targetSprite->getPosition();
 
     
-    playUnitHitSfx(attacker, target);
+    playUnitHitSfx(attacker, target.loot);
 
-    int dmg = AttackVisitor::computeDamage(attacker, target);
-    target.hp -= dmg;
-    if (target.hp < 0) target.hp = 0;
+    int dmg = AttackVisitor::computeDamage(attacker, target.category);
+    damageBuilding(target, dmg, attacker.unitId);
 
     attacker.startAttackCooldown();
 
     punchScale(targetSprite, 12345);
-    ensureHpBar(targetSprite, target.hp, target.hpMax, false);
+    ensureHpBar(targetSprite, target.building->hp, target.building->hpMax, false);
     showDamage(targetSprite->getParent(), tp, dmg);
     return true;
 }
 
+// Damages every standing wall within radiusTiles (grid cells) of the target wall.
+static void applyWallSplash(const EnemyBuildingRuntime& targetWall,
+    float radiusTiles,
+    int wallDmg,
+    std::vector<EnemyBuildingRuntime>& enemyBuildings,
+    const BuildingSpatialIndex* buildingIndex)
+{
+    auto hitWall = [&](EnemyBuildingRuntime& e) {
+        if (!e.building || e.building->hp <= 0 || !e.sprite) return;
+
+        damageBuilding(e, wallDmg, UNIT_BOMBER);
+
+        punchScale(e.sprite, 22345);
+        CombatSystem::ensureHpBar(e.sprite, e.building->hp, e.building->hpMax, false);
+        showDamage(e.sprite->getParent(), e.sprite->getPosition(), wallDmg);
+    };
+
+    const float radius = radiusTiles + 0.001f;
+    const float tr = (float)targetWall.r;
+    const float tc = (float)targetWall.c;
+
+    if (buildingIndex && !buildingIndex->empty())
+    {
+        buildingIndex->forEachInRadius(tr, tc, radius, 10, [&](int index, float) {
+            if (index < (int)enemyBuildings.size()) hitWall(enemyBuildings[(size_t)index]);
+        });
+        return;
+    }
+
+    const float radiusSq = radius * radius;
+    for (auto& e : enemyBuildings)
+    {
+        if (e.id != 10) continue;
+        const float dr = (float)e.r - tr;
+        const float dc = (float)e.c - tc;
+        if (dr * dr + dc * dc > radiusSq) continue;
+        hitWall(e);
+    }
+}
+
 bool CombatSystem::tryBomberExplode(UnitBase& bomber,
     Sprite* bomberSprite,
+    const WallStats& bomberWall,
     EnemyBuildingRuntime& targetWall,
-    std::vector<EnemyBuildingRuntime>& enemyBuildings)
+    std::vector<EnemyBuildingRuntime>& enemyBuildings,
+    const BuildingSpatialIndex* buildingIndex)
 {
     if (!bomberSprite || !targetWall.sprite || !targetWall.building) return false;
     if (bomber.isDead()) return false;
@@ -314,35 +491,13 @@ bool CombatSystem::tryBomberExplode(UnitBase& bomber,
     
     SoundManager::playSfxRandom("wall_breaker_attack", 1.0f);
 
-    
-    const WallBreaker* wb = dynamic_cast<const WallBreaker*>(&bomber);
-    int multiplier = wb ? wb->wallDamageMultiplier : 40;
-    float radiusTiles = wb ? wb->damageRadiusTiles : 2.0f;
-    int wallDmg = std::max(1, bomber.damage * multiplier);
+    // The x40 wall bonus lives in the damage matrix like every other bonus.
+    float radiusTiles = bomberWall.damageRadiusTiles;
+    int wallDmg = AttackVisitor::computeDamage(bomber, BUILDING_CATEGORY_WALL);
 
-    int tr = targetWall.r;
-    int tc = targetWall.c;
+    applyWallSplash(targetWall, radiusTiles, wallDmg, enemyBuildings, buildingIndex);
 
-    for (auto& e : enemyBuildings)
-    {
-        if (!e.building || e.building->hp <= 0 || !e.sprite) continue;
-        if (e.id != 10) continue;
-
-        float dr = (float)(e.r - tr);
-        float dc = (float)(e.c - tc);
-        float dist = std::sqrt(dr * dr + dc * dc);
-        if (dist > radiusTiles + 0.001f) continue;
-
-        e.building->hp -= wallDmg;
-        if (e.building->hp < 0) e.building->hp = 0;
-
-        punchScale(e.sprite, 22345);
-        ensureHpBar(e.sprite, e.building->hp, e.building->hpMax, false);
-        showDamage(e.sprite->getParent(), e.sprite->getPosition(), wallDmg);
-    }
-
-    
-    bomber.hp = 0;
+    killBomber(bomber, targetWall);
 
     
     showDamage(bomberSprite->getParent(), bp, 999);
@@ -352,8 +507,10 @@ bool CombatSystem::tryBomberExplode(UnitBase& bomber,
 
 bool CombatSystem::bomberExplodeNoRange(UnitBase& bomber,
     Sprite* bomberSprite,
+    const WallStats& bomberWall,
     EnemyBuildingRuntime& targetWall,
-    std::vector<EnemyBuildingRuntime>& enemyBuildings)
+    std::vector<EnemyBuildingRuntime>& enemyBuildings,
+    const BuildingSpatialIndex* buildingIndex)
 {
     if (!bomberSprite || !targetWall.sprite || !targetWall.building) return false;
     if (bomber.isDead()) return false;
@@ -362,35 +519,13 @@ bool CombatSystem::bomberExplodeNoRange(UnitBase& bomber,
 
     if (!bomber.canAttack()) return false;
 
-    
-    const WallBreaker* wb = dynamic_cast<const WallBreaker*>(&bomber);
-    int multiplier = wb ? wb->wallDamageMultiplier : 40;
-    float radiusTiles = wb ? wb->damageRadiusTiles : 2.0f;
-    int wallDmg = std::max(1, bomber.damage * multiplier);
-
-    int tr = targetWall.r;
-    int tc = targetWall.c;
-
-    for (auto& e : enemyBuildings)
-    {
-        if (!e.building || e.building->hp <= 0 || !e.sprite) continue;
-        if (e.id != 10) continue;
+    // The x40 wall bonus lives in the damage matrix like every other bonus.
+    float radiusTiles = bomberWall.damageRadiusTiles;
+    int wallDmg = AttackVisitor::computeDamage(bomber, BUILDING_CATEGORY_WALL);
 
-        float dr = (float)(e.r - tr);
-        float dc = (float)(e.c - tc);
-        float dist = std::sqrt(dr * dr + dc * dc);
-        if (dist > radiusTiles + 0.001f) continue;
+    applyWallSplash(targetWall, radiusTiles, wallDmg, enemyBuildings, buildingIndex);
 
-        e.building->hp -= wallDmg;
-        if (e.building->hp < 0) e.building->hp = 0;
-
-        punchScale(e.sprite, 22345);
-        ensureHpBar(e.sprite, e.building->hp, e.building->hpMax, false);
-        showDamage(e.sprite->getParent(), e.sprite->getPosition(), wallDmg);
-    }
-
-    
-    bomber.hp = 0;
+    killBomber(bomber, targetWall);
 
     Vec2 bp = bomberSprite->getPosition();
     showDamage(bomberSprite->getParent(), bp, 999);
@@ -399,35 +534,24 @@ bool CombatSystem::bomberExplodeNoRange(UnitBase& bomber,
 }
 
 bool CombatSystem::tryDefenseShoot(float dt,
-    Building& defense,
-    Sprite* defenseSprite,
+    EnemyBuildingRuntime& defense,
     std::vector<BattleUnitRuntime>& units,
-    float& cooldown,
-    float cellSizePx)
+    float cellSizePx,
+    ProjectileSystem* projectiles,
+    UnitPositionsSoA* positions,
+    const UnitSpatialHash* unitHash)
 {
-    if (!defenseSprite) return false;
-    if (defense.hp <= 0) return false;
+    Sprite* defenseSprite = defense.sprite;
+    if (!defenseSprite || !defense.building) return false;
+    if (defense.building->hp <= 0) return false;
 
-    float dmgPerHit = 0.0f;
-    float atkPerSec = 0.0f;
-    int rangeCells = 0;
+    const DefenseStats& stats = defense.defense;
+    if (stats.kind == DefenseStats::NONE) return false;
 
-    if (auto t = dynamic_cast<ArrowTower*>(&defense))
-    {
-        dmgPerHit = t->damagePerHit;
-        atkPerSec = t->attacksPerSecond;
-        rangeCells = t->rangeCells;
-    }
-    else if (auto c = dynamic_cast<Cannon*>(&defense))
-    {
-        dmgPerHit = c->damagePerHit;
-        atkPerSec = c->attacksPerSecond;
-        rangeCells = c->rangeCells;
-    }
-    else
-    {
-        return false;
-    }
+    float dmgPerHit = stats.damagePerHit;
+    float atkPerSec = stats.attacksPerSecond;
+    int rangeCells = stats.rangeCells;
+    float& cooldown = defense.defenseCooldown;
 
     if (atkPerSec <= 0.0001f) return false;
 
@@ -439,20 +563,48 @@ bool CombatSystem::tryDefenseShoot(float dt,
 
     
     int best = -1;
-    float bestDist = 1e30f;
     Vec2 ep = defenseSprite->getPosition();
+    const float rangeSq = rangePx * rangePx;
 
-    for (int i = 0; i < (int)units.size(); ++i)
+    if (positions && positions->x.size() == units.size() && unitHash)
     {
-        auto& u = units[i];
-        if (!u.unit || !u.sprite) continue;
-        if (u.unit->isDead()) continue;
-
-        float d = u.sprite->getPosition().distance(ep);
-        if (d <= rangePx && d < bestDist)
+        // Sweep only the units bucketed near this defense. Dead ones still read
+        // FAR_AWAY from the positions snapshot.
+        unitHash->gatherCandidates(ep, rangePx, s_targetCandidates);
+        const size_t count = s_targetCandidates.size();
+        s_targetX.resize(count);
+        s_targetY.resize(count);
+        for (size_t k = 0; k < count; ++k)
         {
-            bestDist = d;
-            best = i;
+            const size_t idx = (size_t)s_targetCandidates[k];
+            const bool known = idx < units.size();
+            s_targetX[k] = known ? positions->x[idx] : UnitPositionsSoA::FAR_AWAY;
+            s_targetY[k] = known ? positions->y[idx] : UnitPositionsSoA::FAR_AWAY;
+        }
+        const int local = nearestInRange(s_targetX.data(), s_targetY.data(), (int)count,
+            ep.x, ep.y, rangePx);
+        best = local >= 0 ? s_targetCandidates[(size_t)local] : -1;
+    }
+    else if (positions && positions->x.size() == units.size())
+    {
+        best = nearestInRange(positions->x.data(), positions->y.data(), (int)units.size(),
+            ep.x, ep.y, rangePx);
+    }
+    else
+    {
+        float bestDistSq = 1e30f;
+        for (int i = 0; i < (int)units.size(); ++i)
+        {
+            auto& u = units[i];
+            if (!u.unit || !u.sprite) continue;
+            if (u.unit->isDead()) continue;
+
+            float d2 = u.sprite->getPosition().distanceSquared(ep);
+            if (d2 <= rangeSq && d2 < bestDistSq)
+            {
+                bestDistSq = d2;
+                best = i;
+            }
         }
     }
     if (best < 0) return false;
@@ -462,25 +614,53 @@ bool CombatSystem::tryDefenseShoot(float dt,
 
     // If this defense is a cannon, rotate its barrel sprite towards the chosen victim.
     // We do this before playing SFX/damage so the feedback feels immediate.
-    if (dynamic_cast<Cannon*>(&defense) && victim.sprite)
+    if (stats.kind == DefenseStats::CANNON && victim.sprite)
     {
-        UpdateCannonFacingSprite(defenseSprite, ep, victim.sprite->getPosition());
+        Vec2 d = victim.sprite->getPosition() - ep;
+        int facing = pickHexFacing((int)d.x, (int)d.y);
+        if (facing != defense.facing && s_cannonFrames.apply(defenseSprite, facing))
+            defense.facing = facing;
     }
 
-    if (dynamic_cast<ArrowTower*>(&defense)) {
+    if (stats.kind == DefenseStats::ARROW_TOWER) {
         SoundManager::playSfxRandom("arrow_hit", 1.0f);
-    } else if (dynamic_cast<Cannon*>(&defense)) {
+    } else if (stats.kind == DefenseStats::CANNON) {
         SoundManager::playSfxRandom("cannon_attack", 1.0f);
     }
     int dmg = (int)std::ceil(std::max(1.0f, dmgPerHit));
+    cooldown = atkInterval;
 
-    victim.unit->takeDamage(dmg);
+    if (projectiles && victim.sprite)
+    {
+        projectiles->fire(stats.kind == DefenseStats::CANNON ? ProjectileSystem::CANNONBALL : ProjectileSystem::ARROW,
+            ep, victim.unit.get(), victim.sprite, dmg, defense.id, defense.saveIndex);
+        return true;
+    }
+
+    damageUnit(*victim.unit, dmg, defense.id, defense.saveIndex);
+    // Later defenses this tick must not pick a unit that just died.
+    if (positions && victim.unit->isDead() && best < (int)positions->x.size())
+    {
+        positions->x[(size_t)best] = UnitPositionsSoA::FAR_AWAY;
+        positions->y[(size_t)best] = UnitPositionsSoA::FAR_AWAY;
+    }
 
     
     ensureHpBar(victim.sprite, victim.unit->hp, victim.unit->hpMax, true);
     showDamage(victim.sprite ? victim.sprite->getParent() : nullptr,
         victim.sprite ? victim.sprite->getPosition() : ep, dmg);
 
-    cooldown = atkInterval;
     return true;
 }
+
+void CombatSystem::resolveProjectileHit(const ProjectileHit& hit)
+{
+    // The target may have been killed by an earlier hit or left the battle in flight.
+    if (!hit.target || hit.target->isDead()) return;
+
+    damageUnit(*hit.target, hit.damage, hit.sourceId, hit.sourceIndex);
+
+    ensureHpBar(hit.targetSprite, hit.target->hp, hit.target->hpMax, true);
+    showDamage(hit.targetSprite ? hit.targetSprite->getParent() : nullptr,
+        hit.targetSprite ? hit.targetSprite->getPosition() : hit.pos, hit.damage);
+}
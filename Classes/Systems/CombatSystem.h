@@ -7,9 +7,21 @@
 #include "GameObjects/Units/UnitBase.h"
 #include "GameObjects/Buildings/Building.h"
 #include "Systems/AISystem.h"
+#include "Patterns/DamageMatrix.h"
 
 namespace CombatSystem {
 
+    // Fills the cached DefenseStats/LootStats of an enemy building. Call once after
+    // the runtime's building is created; this is the only place that inspects its type.
+    void initBuildingStats(EnemyBuildingRuntime& e);
+
+    // Fills the cached WallStats of a freshly spawned unit.
+    void initUnitStats(BattleUnitRuntime& u);
+
+    // Preloads the directional cannon frames, each scaled to fit cannonBox (world px).
+    // Call once per battle before the first shot.
+    void prepareDefenseVisuals(const cocos2d::Size& cannonBox);
+
     
     // Returns whether InRange is true.
 
@@ -24,14 +36,16 @@ namespace CombatSystem {
     
     void ensureHpBar(cocos2d::Sprite* sprite, int hp, int hpMax, bool isUnit);
 
+    // Drops the health bar of a sprite (e.g. once a building turns into a ruin).
+    void removeHpBar(cocos2d::Sprite* sprite);
+
     
     // TODO: Add a brief description.
 
     
     bool tryUnitAttackBuilding(UnitBase& attacker,
         cocos2d::Sprite* attackerSprite,
-        Building& target,
-        cocos2d::Sprite* targetSprite);
+        EnemyBuildingRuntime& target);
 
     
     
@@ -41,14 +55,14 @@ namespace CombatSystem {
     
     bool unitHitBuildingNoRange(UnitBase& attacker,
         cocos2d::Sprite* attackerSprite,
-        Building& target,
-        cocos2d::Sprite* targetSprite);
+        EnemyBuildingRuntime& target);
 
     
     
     
     
-    // TODO: Add a brief description.
+    // Blows the bomber up once targetWall is in attack range, damaging every wall within
+    // its radius (queried through buildingIndex when given).
 
     
     
@@ -56,28 +70,45 @@ namespace CombatSystem {
     
     bool tryBomberExplode(UnitBase& bomber,
         cocos2d::Sprite* bomberSprite,
+        const WallStats& bomberWall,
         EnemyBuildingRuntime& targetWall,
-        std::vector<EnemyBuildingRuntime>& enemyBuildings);
+        std::vector<EnemyBuildingRuntime>& enemyBuildings,
+        const BuildingSpatialIndex* buildingIndex = nullptr);
 
     
     
-    // TODO: Add a brief description.
+    // Same as tryBomberExplode without the range check (the AI already arrived).
 
     
     
     bool bomberExplodeNoRange(UnitBase& bomber,
         cocos2d::Sprite* bomberSprite,
+        const WallStats& bomberWall,
         EnemyBuildingRuntime& targetWall,
-        std::vector<EnemyBuildingRuntime>& enemyBuildings);
+        std::vector<EnemyBuildingRuntime>& enemyBuildings,
+        const BuildingSpatialIndex* buildingIndex = nullptr);
 
     
-    // TODO: Add a brief description.
+    // Returns the index of the nearest of `count` SoA points within range of (cx, cy),
+    // or -1. Squared distances, SSE2/AVX2 with a scalar tail; ties go to the lower index.
+    int nearestInRange(const float* xs, const float* ys, int count,
+        float cx, float cy, float range);
+
+    // Fires the defense at the nearest unit in range once its cooldown allows. With a
+    // ProjectileSystem the damage lands on arrival (resolveProjectileHit); without
+    // one it is applied immediately.
+    // Targets come from the SoA positions sweep when given, else a scalar scan. With a
+    // unit hash as well, only units in the hash cells around the range are swept.
 
     
     bool tryDefenseShoot(float dt,
-        Building& defense,
-        cocos2d::Sprite* defenseSprite,
+        EnemyBuildingRuntime& defense,
         std::vector<BattleUnitRuntime>& units,
-        float& cooldown,
-        float cellSizePx);
+        float cellSizePx,
+        ProjectileSystem* projectiles = nullptr,
+        UnitPositionsSoA* positions = nullptr,
+        const UnitSpatialHash* unitHash = nullptr);
+
+    // Applies the damage of a projectile that reached its target.
+    void resolveProjectileHit(const ProjectileHit& hit);
 }
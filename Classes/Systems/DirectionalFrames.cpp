@@ -0,0 +1,76 @@
+// File: DirectionalFrames.cpp
+// Brief: Implements the DirectionalFrames component.
+#include "Systems/DirectionalFrames.h"
+
+#include <algorithm>
+
+using namespace cocos2d;
+
+HexFacing pickHexFacing(int dx, int dy)
+{
+    if (dx == 0 && dy == 0) return FACING_SOUTH;
+
+    // |angle from the x axis| >= 60 degrees  <=>  dy^2 >= 3 * dx^2.
+    const long long dx2x3 = 3LL * dx * dx;
+    const long long dy2 = (long long)dy * dy;
+
+    if (dy >= 0)
+    {
+        if (dy2 >= dx2x3 && dy > 0) return FACING_NORTH;
+        return (dx > 0) ? FACING_NORTHEAST : FACING_NORTHWEST;
+    }
+
+    if (dy2 > dx2x3) return FACING_SOUTH;
+    return (dx > 0) ? FACING_SOUTHEAST : FACING_SOUTHWEST;
+}
+
+bool DirectionalFrames::load(const char* const* paths, int count, const Size& box)
+{
+    for (int i = 0; i < _count; ++i)
+    {
+        if (_frames[i]) _frames[i]->release();
+        _frames[i] = nullptr;
+    }
+    _count = 0;
+
+    if (!paths || count <= 0 || count > MAX_FACINGS) return false;
+
+    auto* cache = SpriteFrameCache::getInstance();
+    for (int i = 0; i < count; ++i)
+    {
+        SpriteFrame* frame = cache->getSpriteFrameByName(paths[i]);
+        if (!frame)
+        {
+            auto* tex = Director::getInstance()->getTextureCache()->addImage(paths[i]);
+            if (!tex) return false;
+
+            const Size ts = tex->getContentSize();
+            frame = SpriteFrame::createWithTexture(tex, Rect(0, 0, ts.width, ts.height));
+            if (!frame) return false;
+            cache->addSpriteFrame(frame, paths[i]);
+        }
+
+        // Keep our own reference so purging unused cache frames cannot pull it away.
+        frame->retain();
+        _frames[i] = frame;
+
+        const Size fs = frame->getOriginalSize();
+        float s = 1.0f;
+        if (fs.width > 0.0f && fs.height > 0.0f && box.width > 0.0f && box.height > 0.0f)
+        {
+            s = std::min(box.width / fs.width, box.height / fs.height);
+        }
+        _scale[i] = std::max(0.0001f, s);
+        _count = i + 1;
+    }
+    return true;
+}
+
+bool DirectionalFrames::apply(Sprite* sprite, int facing) const
+{
+    if (!sprite || facing < 0 || facing >= _count || !_frames[facing]) return false;
+
+    sprite->setSpriteFrame(_frames[facing]);
+    sprite->setScale(_scale[facing]);
+    return true;
+}
@@ -0,0 +1,50 @@
+// File: DirectionalFrames.h
+// Brief: Declares the DirectionalFrames component.
+#pragma once
+
+#include "cocos2d.h"
+
+// The six facings of the directional defense art, ordered as in Resources/cannon.
+enum HexFacing {
+    FACING_NORTH = 0,
+    FACING_NORTHEAST,
+    FACING_SOUTHEAST,
+    FACING_SOUTH,
+    FACING_SOUTHWEST,
+    FACING_NORTHWEST,
+    HEX_FACING_COUNT
+};
+
+// Snaps the direction (dx, dy) to the nearest 60-degree sector (N at 60..120 degrees,
+// NE at 0..60, and so on) using only integer comparisons. (0, 0) faces south.
+HexFacing pickHexFacing(int dx, int dy);
+
+// DirectionalFrames is the frame table of one directional sprite (e.g. the cannon).
+//
+// Frames are loaded once into SpriteFrameCache together with the scale that fits each
+// of them into a fixed on-screen box, so turning a sprite is one frame pointer swap
+// plus one setScale. Any defense with per-direction art can own one of these.
+
+class DirectionalFrames {
+public:
+    static constexpr int MAX_FACINGS = 8;
+
+    DirectionalFrames() = default;
+    DirectionalFrames(const DirectionalFrames&) = delete;
+    DirectionalFrames& operator=(const DirectionalFrames&) = delete;
+
+    // Loads one frame per facing (paths in facing order) and precomputes the scales
+    // that fit each frame into box while keeping its aspect ratio.
+    bool load(const char* const* paths, int count, const cocos2d::Size& box);
+
+    // Returns whether IsLoaded is true.
+    bool isLoaded() const { return _count > 0; }
+
+    // Shows the given facing on sprite. Returns false if it is out of range.
+    bool apply(cocos2d::Sprite* sprite, int facing) const;
+
+private:
+    cocos2d::SpriteFrame* _frames[MAX_FACINGS] = {};
+    float _scale[MAX_FACINGS] = {};
+    int _count = 0;
+};
@@ -6,6 +6,11 @@
 #include <queue>
 #include <limits>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define COC_PATHFINDING_SSE2 1
+#endif
+
 using namespace cocos2d;
 
 Vec2 Pathfinding::stepTowards(const Vec2& cur, const Vec2& dst, float step, float stopDistance)
@@ -122,6 +127,122 @@ std::vector<Pathfinding::GridPos> Pathfinding::findPathAStar(int rows, int cols,
     return empty;
 }
 
+static void chebyshevDistanceTransformScalar(unsigned char* grid, int rows, int cols, int stride)
+{
+    auto at = [&](int r, int c) -> unsigned char& { return grid[(size_t)r * (size_t)stride + (size_t)c]; };
+    auto relax = [](unsigned char& v, unsigned char n) {
+        int cand = (int)n + 1;
+        if (cand > 255) cand = 255;
+        if (cand < v) v = (unsigned char)cand;
+    };
+
+    // Forward pass: left, up-left, up, up-right.
+    for (int r = 0; r < rows; ++r)
+    {
+        for (int c = 0; c < cols; ++c)
+        {
+            unsigned char& v = at(r, c);
+            if (c > 0) relax(v, at(r, c - 1));
+            if (r > 0)
+            {
+                relax(v, at(r - 1, c));
+                if (c > 0) relax(v, at(r - 1, c - 1));
+                if (c + 1 < cols) relax(v, at(r - 1, c + 1));
+            }
+        }
+    }
+
+    // Backward pass: right, down-right, down, down-left.
+    for (int r = rows - 1; r >= 0; --r)
+    {
+        for (int c = cols - 1; c >= 0; --c)
+        {
+            unsigned char& v = at(r, c);
+            if (c + 1 < cols) relax(v, at(r, c + 1));
+            if (r + 1 < rows)
+            {
+                relax(v, at(r + 1, c));
+                if (c > 0) relax(v, at(r + 1, c - 1));
+                if (c + 1 < cols) relax(v, at(r + 1, c + 1));
+            }
+        }
+    }
+}
+
+#ifdef COC_PATHFINDING_SSE2
+// Min of a row with its left and right neighbours; lanes shifted in from outside are 255.
+static inline __m128i rowMin3(__m128i v, __m128i edgeLo, __m128i edgeHi)
+{
+    __m128i left = _mm_or_si128(_mm_slli_si128(v, 1), edgeLo);
+    __m128i right = _mm_or_si128(_mm_srli_si128(v, 1), edgeHi);
+    return _mm_min_epu8(v, _mm_min_epu8(left, right));
+}
+
+// 16-lane Jacobi relaxation: every pass applies one 3x3 min-dilation to each
+// 16-byte row chunk. Converges after (max distance + 1) passes.
+static void chebyshevDistanceTransformSse2(unsigned char* grid, int rows, int cols, int stride)
+{
+    (void)cols;
+    const __m128i ones = _mm_set1_epi8(1);
+    const __m128i full = _mm_set1_epi8((char)0xFF);
+    const __m128i edgeLo = _mm_srli_si128(full, 15);   // lane 0 only
+    const __m128i edgeHi = _mm_slli_si128(full, 15);   // lane 15 only
+    const int chunks = stride / 16;
+
+    for (int pass = 0; pass < rows + stride; ++pass)
+    {
+        int changed = 0;
+        for (int k = 0; k < chunks; ++k)
+        {
+            // Rows outside the grid and lanes past the chunk edges read as "far".
+            auto load = [&](int r) -> __m128i {
+                if (r < 0 || r >= rows) return full;
+                return _mm_loadu_si128((const __m128i*)(grid + (size_t)r * (size_t)stride + (size_t)k * 16));
+            };
+            auto hmin = [&](int r) -> __m128i {
+                if (r < 0 || r >= rows) return full;
+                __m128i lo = (k > 0) ? _mm_set1_epi8((char)grid[(size_t)r * (size_t)stride + (size_t)k * 16 - 1]) : full;
+                __m128i hi = (k + 1 < chunks) ? _mm_set1_epi8((char)grid[(size_t)r * (size_t)stride + (size_t)k * 16 + 16]) : full;
+                return rowMin3(load(r), _mm_and_si128(lo, edgeLo), _mm_and_si128(hi, edgeHi));
+            };
+
+            __m128i hPrev = hmin(-1);
+            __m128i hCur = hmin(0);
+            for (int r = 0; r < rows; ++r)
+            {
+                __m128i hNext = hmin(r + 1);
+                __m128i v = load(r);
+                __m128i n = _mm_adds_epu8(_mm_min_epu8(hPrev, _mm_min_epu8(hCur, hNext)), ones);
+                __m128i nv = _mm_min_epu8(v, n);
+                changed |= (_mm_movemask_epi8(_mm_cmpeq_epi8(nv, v)) != 0xFFFF);
+                _mm_storeu_si128((__m128i*)(grid + (size_t)r * (size_t)stride + (size_t)k * 16), nv);
+                hPrev = hCur;
+                hCur = hNext;
+            }
+        }
+        if (!changed) break;
+    }
+}
+#endif
+
+void Pathfinding::chebyshevDistanceTransform(unsigned char* grid, int rows, int cols, int stride)
+{
+    if (!grid || rows <= 0 || cols <= 0 || stride < cols) return;
+
+#ifdef COC_PATHFINDING_SSE2
+    if (stride % 16 == 0)
+    {
+        // Padding lanes join the transform as free cells, so reset them first.
+        for (int r = 0; r < rows; ++r)
+            std::fill(grid + (size_t)r * (size_t)stride + (size_t)cols,
+                grid + (size_t)(r + 1) * (size_t)stride, (unsigned char)255);
+        chebyshevDistanceTransformSse2(grid, rows, cols, stride);
+        return;
+    }
+#endif
+    chebyshevDistanceTransformScalar(grid, rows, cols, stride);
+}
+
 std::vector<Vec2> Pathfinding::makeDirectPath(const Vec2& start, const Vec2& end, int segments)
 {
     std::vector<Vec2> path;
@@ -39,6 +39,18 @@ namespace Pathfinding {
         int maxIters);
 
     
+    
+    // Computes an exact Chebyshev (8-neighbour) distance transform in place.
+    // On input seed cells must be 0 and every other cell 255; on output each cell
+    // holds its distance to the nearest seed, saturated at 255. Rows are `stride`
+    // bytes apart; padding bytes past `cols` may be overwritten. Uses SSE2 when
+    // stride is a multiple of 16, a two-pass scalar sweep otherwise.
+
+    
+    
+    void chebyshevDistanceTransform(unsigned char* grid, int rows, int cols, int stride);
+
+    
     // TODO: Add a brief description.
 
     
@@ -0,0 +1,186 @@
+// File: ProjectileSystem.cpp
+// Brief: Implements the ProjectileSystem component.
+#include "Systems/ProjectileSystem.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace cocos2d;
+
+static const Color4F kArrowColor(0.85f, 0.75f, 0.55f, 1.0f);
+static const Color4F kCannonballColor(0.15f, 0.15f, 0.15f, 1.0f);
+static const float kArrowLengthPx = 12.0f;
+static const float kArrowWidthPx = 1.2f;
+static const float kCannonballRadiusPx = 4.0f;
+
+ProjectileSystem::~ProjectileSystem()
+{
+    if (_draw) _draw->release();
+}
+
+void ProjectileSystem::attach(Node* parent, int zOrder)
+{
+    if (_draw)
+    {
+        _draw->removeFromParent();
+        _draw->release();
+        _draw = nullptr;
+    }
+    if (!parent) return;
+
+    _draw = DrawNode::create();
+    if (!_draw) return;
+    _draw->retain();
+    parent->addChild(_draw, zOrder);
+}
+
+void ProjectileSystem::fire(Kind kind, const Vec2& from,
+    UnitBase* target, Sprite* targetSprite, int damage,
+    int sourceId, int sourceIndex)
+{
+    if (!targetSprite) return;
+
+    const Vec2 to = targetSprite->getPosition();
+    const float cells = (kind == CANNONBALL) ? CANNONBALL_SPEED_CELLS : ARROW_SPEED_CELLS;
+
+    _x.push_back(from.x);
+    _y.push_back(from.y);
+    _tx.push_back(to.x);
+    _ty.push_back(to.y);
+    _speed.push_back(cells * std::max(8.0f, _cellSizePx));
+    _arrived.push_back(0);
+
+    Payload p;
+    p.target = target;
+    p.targetSprite = targetSprite;
+    p.damage = damage;
+    p.kind = kind;
+    p.sourceId = sourceId;
+    p.sourceIndex = sourceIndex;
+    _payload.push_back(p);
+}
+
+void ProjectileSystem::update(float dt)
+{
+    _hits.clear();
+    const int n = (int)_x.size();
+    if (n == 0 || dt <= 0.0f) return;
+
+    // Gather: refresh homing targets (the only pass that chases pointers).
+    for (int i = 0; i < n; ++i)
+    {
+        const Sprite* s = _payload[(size_t)i].targetSprite;
+        if (!s) continue;
+        const Vec2 p = s->getPosition();
+        _tx[(size_t)i] = p.x;
+        _ty[(size_t)i] = p.y;
+    }
+
+    // Advance: straight-line step towards the target, clamped so nothing overshoots.
+    // Plain float arrays and no branches keep this loop vectorizable.
+    float* x = _x.data();
+    float* y = _y.data();
+    const float* tx = _tx.data();
+    const float* ty = _ty.data();
+    const float* speed = _speed.data();
+    unsigned char* arrived = _arrived.data();
+    for (int i = 0; i < n; ++i)
+    {
+        const float dx = tx[i] - x[i];
+        const float dy = ty[i] - y[i];
+        const float d2 = dx * dx + dy * dy;
+        const float step = speed[i] * dt;
+        const float k = std::min(1.0f, step / std::sqrt(std::max(d2, 1e-6f)));
+        x[i] += dx * k;
+        y[i] += dy * k;
+        arrived[i] = (unsigned char)(d2 <= step * step);
+    }
+
+    // Emit: arrivals become hit events and leave the arrays.
+    for (int i = n - 1; i >= 0; --i)
+    {
+        if (!_arrived[(size_t)i]) continue;
+
+        const Payload& p = _payload[(size_t)i];
+        ProjectileHit hit;
+        hit.target = p.target;
+        hit.targetSprite = p.targetSprite;
+        hit.pos = Vec2(_x[(size_t)i], _y[(size_t)i]);
+        hit.damage = p.damage;
+        hit.sourceId = p.sourceId;
+        hit.sourceIndex = p.sourceIndex;
+        _hits.push_back(hit);
+
+        removeAt(i);
+    }
+}
+
+void ProjectileSystem::render()
+{
+    if (!_draw) return;
+    _draw->clear();
+
+    const int n = (int)_x.size();
+    for (int i = 0; i < n; ++i)
+    {
+        const Vec2 p(_x[(size_t)i], _y[(size_t)i]);
+        if (_payload[(size_t)i].kind == CANNONBALL)
+        {
+            _draw->drawDot(p, kCannonballRadiusPx, kCannonballColor);
+            continue;
+        }
+
+        // Arrows are short segments trailing behind the head.
+        Vec2 dir(_tx[(size_t)i] - p.x, _ty[(size_t)i] - p.y);
+        const float len = dir.length();
+        if (len > 0.001f) dir *= (kArrowLengthPx / len);
+        _draw->drawSegment(p - dir, p, kArrowWidthPx, kArrowColor);
+    }
+}
+
+void ProjectileSystem::forgetTarget(const UnitBase* target)
+{
+    if (!target) return;
+    for (auto& p : _payload)
+    {
+        if (p.target != target) continue;
+        p.target = nullptr;
+        p.targetSprite = nullptr;
+    }
+}
+
+void ProjectileSystem::clear()
+{
+    _x.clear();
+    _y.clear();
+    _tx.clear();
+    _ty.clear();
+    _speed.clear();
+    _arrived.clear();
+    _payload.clear();
+    _hits.clear();
+    if (_draw) _draw->clear();
+}
+
+void ProjectileSystem::removeAt(int i)
+{
+    const size_t last = _x.size() - 1;
+    const size_t k = (size_t)i;
+    if (k != last)
+    {
+        _x[k] = _x[last];
+        _y[k] = _y[last];
+        _tx[k] = _tx[last];
+        _ty[k] = _ty[last];
+        _speed[k] = _speed[last];
+        _arrived[k] = _arrived[last];
+        _payload[k] = _payload[last];
+    }
+    _x.pop_back();
+    _y.pop_back();
+    _tx.pop_back();
+    _ty.pop_back();
+    _speed.pop_back();
+    _arrived.pop_back();
+    _payload.pop_back();
+}
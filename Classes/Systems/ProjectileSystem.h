@@ -0,0 +1,97 @@
+// File: ProjectileSystem.h
+// Brief: Declares the ProjectileSystem component.
+#pragma once
+#include "cocos2d.h"
+#include <vector>
+
+class UnitBase;
+
+// ProjectileHit is emitted when a projectile reaches its target.
+struct ProjectileHit {
+    UnitBase* target = nullptr;              // nullptr if the target left the battle
+    cocos2d::Sprite* targetSprite = nullptr;
+    cocos2d::Vec2 pos = cocos2d::Vec2::ZERO;
+    int damage = 0;
+    int sourceId = 0;       // building id of the defense that fired
+    int sourceIndex = -1;   // its save index
+};
+
+// ProjectileSystem simulates defense projectiles (arrows, cannonballs) in flight.
+//
+// Projectiles are stored as parallel arrays (structure of arrays) so the per-tick
+// advance is one branch-free loop over plain floats. Arrivals are collected as
+// ProjectileHit events for the caller to resolve, and everything in flight is drawn
+// into a single DrawNode (one batched draw call). Records are swap-removed, so the
+// arrays stay contiguous and only grow to the peak number in flight.
+
+class ProjectileSystem {
+public:
+    // Kind selects speed and look.
+    enum Kind { ARROW = 0, CANNONBALL = 1 };
+
+    ProjectileSystem() = default;
+    ~ProjectileSystem();
+
+    ProjectileSystem(const ProjectileSystem&) = delete;
+    ProjectileSystem& operator=(const ProjectileSystem&) = delete;
+
+    // Creates the draw node under parent (the battle world) at the given z order.
+    void attach(cocos2d::Node* parent, int zOrder);
+
+    // Sets the world size of one grid cell; speeds are expressed in cells per second.
+    void setCellSizePx(float cellSizePx) { _cellSizePx = cellSizePx; }
+
+    // Launches a projectile from `from` that homes in on targetSprite. The source is
+    // only passed through to the hit event.
+    void fire(Kind kind, const cocos2d::Vec2& from,
+        UnitBase* target, cocos2d::Sprite* targetSprite, int damage,
+        int sourceId = 0, int sourceIndex = -1);
+
+    // Advances every projectile by dt. Arrivals are appended to hits() (cleared first).
+    void update(float dt);
+
+    // Rebuilds the batched draw of everything in flight.
+    void render();
+
+    // Stops tracking a unit that is about to be destroyed; its projectiles fly on to
+    // the last known position and then hit nothing.
+    void forgetTarget(const UnitBase* target);
+
+    // Removes every projectile.
+    void clear();
+
+    // Returns the hit events of the last update().
+    const std::vector<ProjectileHit>& hits() const { return _hits; }
+
+    // Returns the number of projectiles in flight.
+    int size() const { return (int)_x.size(); }
+
+private:
+    static constexpr float ARROW_SPEED_CELLS = 16.0f;
+    static constexpr float CANNONBALL_SPEED_CELLS = 10.0f;
+
+    // Swap-removes projectile i.
+    void removeAt(int i);
+
+    float _cellSizePx = 32.0f;
+    cocos2d::DrawNode* _draw = nullptr;
+
+    // Hot data, one entry per projectile.
+    std::vector<float> _x, _y;       // current position
+    std::vector<float> _tx, _ty;     // target position (refreshed from the sprite)
+    std::vector<float> _speed;       // px per second
+    std::vector<unsigned char> _arrived;
+
+    // Cold data, only read when gathering targets and emitting hits.
+    struct Payload {
+        UnitBase* target = nullptr;
+        cocos2d::Sprite* targetSprite = nullptr;
+        int damage = 0;
+        int kind = ARROW;
+        int sourceId = 0;
+        int sourceIndex = -1;
+    };
+    std::vector<Payload> _payload;
+
+    std::vector<ProjectileHit> _hits;
+};
@@ -0,0 +1,134 @@
+// File: UnitSpatialHash.cpp
+// Brief: Implements the UnitSpatialHash component.
+#include "Systems/UnitSpatialHash.h"
+
+#include "Systems/AISystem.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace cocos2d;
+
+namespace {
+// Upper bound on buckets; the cell size grows if units are spread wider than this.
+const int kMaxCells = 4096;
+}
+
+void UnitSpatialHash::clear()
+{
+    _cols = 0;
+    _rows = 0;
+    _cellStart.clear();
+    _entries.clear();
+    _present.clear();
+}
+
+void UnitSpatialHash::rebuild(const std::vector<BattleUnitRuntime>& units, float cellSize)
+{
+    const size_t n = units.size();
+    _x.resize(n);
+    _y.resize(n);
+    _present.assign(n, 0);
+    _cellOf.assign(n, -1);
+    _entries.clear();
+
+    // Snapshot positions and find the bounds of the living units.
+    float minX = 0.0f, minY = 0.0f, maxX = 0.0f, maxY = 0.0f;
+    int count = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        const auto& u = units[i];
+        if (!u.unit || !u.sprite || u.unit->isDead()) continue;
+
+        const Vec2& p = u.sprite->getPosition();
+        _x[i] = p.x;
+        _y[i] = p.y;
+        _present[i] = 1;
+
+        if (count == 0) { minX = maxX = p.x; minY = maxY = p.y; }
+        else
+        {
+            minX = std::min(minX, p.x); maxX = std::max(maxX, p.x);
+            minY = std::min(minY, p.y); maxY = std::max(maxY, p.y);
+        }
+        ++count;
+    }
+
+    if (count == 0)
+    {
+        clear();
+        return;
+    }
+
+    _cellSize = std::max(1.0f, cellSize);
+    for (;;)
+    {
+        _cols = (int)std::floor((maxX - minX) / _cellSize) + 1;
+        _rows = (int)std::floor((maxY - minY) / _cellSize) + 1;
+        if ((long long)_cols * (long long)_rows <= kMaxCells) break;
+        _cellSize *= 2.0f;
+    }
+    _invCell = 1.0f / _cellSize;
+    _originX = minX;
+    _originY = minY;
+
+    // Counting sort: bucket sizes, prefix sums, then scatter unit indices.
+    const size_t cells = (size_t)_cols * (size_t)_rows;
+    _cellStart.assign(cells + 1, 0);
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (!_present[i]) continue;
+        const int cell = cellRow(_y[i]) * _cols + cellCol(_x[i]);
+        _cellOf[i] = cell;
+        _cellStart[(size_t)cell + 1]++;
+    }
+    for (size_t c = 0; c < cells; ++c) _cellStart[c + 1] += _cellStart[c];
+
+    _entries.resize((size_t)count);
+    _fill.assign(_cellStart.begin(), _cellStart.end() - 1);
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (!_present[i]) continue;
+        _entries[(size_t)_fill[(size_t)_cellOf[i]]++] = (int)i;
+    }
+}
+
+void UnitSpatialHash::gatherCandidates(const Vec2& center, float radius, std::vector<int>& out) const
+{
+    out.clear();
+    if (_entries.empty() || radius < 0.0f) return;
+
+    int c0, r0, c1, r1;
+    cellRange(center, radius + _cellSize, c0, r0, c1, r1);
+
+    // Cells of one row are adjacent in _entries, so each row is a single copy.
+    for (int r = r0; r <= r1; ++r)
+    {
+        const int first = _cellStart[(size_t)(r * _cols + c0)];
+        const int last = _cellStart[(size_t)(r * _cols + c1 + 1)];
+        out.insert(out.end(), _entries.begin() + first, _entries.begin() + last);
+    }
+    // Bucket order is arbitrary; index order keeps nearest-target ties deterministic.
+    std::sort(out.begin(), out.end());
+}
+
+int UnitSpatialHash::cellCol(float x) const
+{
+    int c = (int)std::floor((x - _originX) * _invCell);
+    return std::max(0, std::min(_cols - 1, c));
+}
+
+int UnitSpatialHash::cellRow(float y) const
+{
+    int r = (int)std::floor((y - _originY) * _invCell);
+    return std::max(0, std::min(_rows - 1, r));
+}
+
+void UnitSpatialHash::cellRange(const Vec2& center, float radius,
+    int& c0, int& r0, int& c1, int& r1) const
+{
+    c0 = cellCol(center.x - radius);
+    c1 = cellCol(center.x + radius);
+    r0 = cellRow(center.y - radius);
+    r1 = cellRow(center.y + radius);
+}
@@ -0,0 +1,96 @@
+// File: UnitSpatialHash.h
+// Brief: Declares the UnitSpatialHash component.
+#pragma once
+#include "cocos2d.h"
+#include <vector>
+
+struct BattleUnitRuntime;
+
+// UnitSpatialHash is a uniform grid over battle unit positions.
+//
+// It is rebuilt once per tick (counting sort into flat cell buckets) and answers
+// radius queries by scanning only the overlapped cells, so separation steering
+// and defense targeting stay linear in the number of units.
+// Positions are snapshotted at rebuild time; queries never touch sprites.
+
+class UnitSpatialHash {
+public:
+    // Rebuilds the grid from every living unit that has a sprite.
+    void rebuild(const std::vector<BattleUnitRuntime>& units, float cellSize);
+
+    // Clears all buckets.
+    void clear();
+
+    // Returns whether the unit at `unitIndex` was inserted by the last rebuild.
+    bool contains(int unitIndex) const {
+        return unitIndex >= 0 && unitIndex < (int)_present.size() && _present[(size_t)unitIndex] != 0;
+    }
+
+    // Returns the snapshot position of an inserted unit.
+    cocos2d::Vec2 positionOf(int unitIndex) const {
+        return cocos2d::Vec2(_x[(size_t)unitIndex], _y[(size_t)unitIndex]);
+    }
+
+    // Updates the snapshot position of an inserted unit. Its bucket is not changed,
+    // so callers should only apply small moves and query with a little slack.
+    void setPosition(int unitIndex, const cocos2d::Vec2& p) {
+        _x[(size_t)unitIndex] = p.x;
+        _y[(size_t)unitIndex] = p.y;
+    }
+
+    // Calls fn(unitIndex, distSq) for every inserted unit within `radius` of `center`.
+    template <typename Fn>
+    void forEachInRadius(const cocos2d::Vec2& center, float radius, Fn&& fn) const
+    {
+        if (_entries.empty() || radius < 0.0f) return;
+
+        int c0, r0, c1, r1;
+        cellRange(center, radius, c0, r0, c1, r1);
+        const float r2 = radius * radius;
+
+        for (int r = r0; r <= r1; ++r)
+        {
+            for (int c = c0; c <= c1; ++c)
+            {
+                const int cell = r * _cols + c;
+                for (int k = _cellStart[(size_t)cell]; k < _cellStart[(size_t)cell + 1]; ++k)
+                {
+                    const int idx = _entries[(size_t)k];
+                    const float dx = _x[(size_t)idx] - center.x;
+                    const float dy = _y[(size_t)idx] - center.y;
+                    const float d2 = dx * dx + dy * dy;
+                    if (d2 <= r2) fn(idx, d2);
+                }
+            }
+        }
+    }
+
+    // Replaces out with every inserted unit in the cells overlapped by `radius` around
+    // `center`, padded by one cell, in ascending index order. No distance test is
+    // done; the padding covers units nudged by setPosition since the rebuild.
+    void gatherCandidates(const cocos2d::Vec2& center, float radius, std::vector<int>& out) const;
+
+private:
+    // Clamped cell rectangle overlapped by the query circle (inclusive).
+    void cellRange(const cocos2d::Vec2& center, float radius,
+        int& c0, int& r0, int& c1, int& r1) const;
+
+    // Cell coordinate of a point, clamped to the grid.
+    int cellCol(float x) const;
+    int cellRow(float y) const;
+
+    float _cellSize = 32.0f;
+    float _invCell = 1.0f / 32.0f;
+    float _originX = 0.0f;
+    float _originY = 0.0f;
+    int _cols = 0;
+    int _rows = 0;
+
+    std::vector<int> _cellStart;   // cells + 1 prefix offsets into _entries
+    std::vector<int> _entries;     // unit indices grouped by cell
+    std::vector<int> _cellOf;      // per unit index; scratch for the scatter pass
+    std::vector<int> _fill;        // per cell write cursor; scratch for the scatter pass
+    std::vector<float> _x;         // per unit index snapshot positions
+    std::vector<float> _y;
+    std::vector<unsigned char> _present;
+};
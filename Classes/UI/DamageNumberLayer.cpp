@@ -0,0 +1,90 @@
+// File: DamageNumberLayer.cpp
+// Brief: Implements the DamageNumberLayer component.
+#include "UI/DamageNumberLayer.h"
+
+#include <cstdio>
+
+using namespace cocos2d;
+
+DamageNumberLayer* DamageNumberLayer::s_current = nullptr;
+
+// Every glyph a damage number can use; the warmup labels carry this text so the
+// shared atlas holds all of them before the first hit.
+static const char* kDamageGlyphs = "-0123456789";
+
+bool DamageNumberLayer::init()
+{
+    if (!Node::init()) return false;
+
+    _pool.setFactory([this]() { return createLabel(); });
+    _pool.warmup(WARMUP_COUNT);
+    _active.reserve(WARMUP_COUNT);
+    return true;
+}
+
+Label* DamageNumberLayer::createLabel()
+{
+    TTFConfig font("fonts/arial.ttf", 20);
+    Label* lab = Label::createWithTTF(font, kDamageGlyphs);
+    if (!lab) lab = Label::createWithSystemFont(kDamageGlyphs, "Arial", 20);
+    if (!lab) return nullptr;
+
+    // Building the quads now (instead of on first draw) fills the glyph atlas.
+    lab->getContentSize();
+    lab->setVisible(false);
+    addChild(lab);
+    return lab;
+}
+
+void DamageNumberLayer::onEnter()
+{
+    Node::onEnter();
+    s_current = this;
+    scheduleUpdate();
+}
+
+void DamageNumberLayer::onExit()
+{
+    if (s_current == this) s_current = nullptr;
+    unscheduleUpdate();
+    Node::onExit();
+}
+
+void DamageNumberLayer::show(const Vec2& pos, int dmg)
+{
+    Label* lab = _pool.acquire();
+    if (!lab) return;
+
+    char text[16];
+    std::snprintf(text, sizeof(text), "-%d", dmg);
+    lab->setString(text);
+
+    ActiveNumber n;
+    n.label = lab;
+    n.start = pos + Vec2(0, OFFSET_Y);
+    lab->setPosition(n.start);
+    lab->setOpacity((uint8_t)START_OPACITY);
+    _active.push_back(n);
+}
+
+void DamageNumberLayer::update(float dt)
+{
+    for (size_t i = 0; i < _active.size();)
+    {
+        ActiveNumber& n = _active[i];
+        n.age += dt;
+
+        float t = n.age / LIFETIME;
+        if (t >= 1.0f)
+        {
+            _pool.release(n.label);
+            _active[i] = _active.back();
+            _active.pop_back();
+            continue;
+        }
+
+        n.label->setPosition(n.start + Vec2(0, RISE_PX * t));
+        n.label->setOpacity((uint8_t)(START_OPACITY * (1.0f - t)));
+        ++i;
+    }
+}
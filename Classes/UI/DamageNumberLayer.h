@@ -0,0 +1,58 @@
+// File: DamageNumberLayer.h
+// Brief: Declares the DamageNumberLayer component.
+#pragma once
+
+#include "cocos2d.h"
+#include <vector>
+
+#include "Utils/ObjectPool.h"
+
+// DamageNumberLayer draws the floating "-N" numbers shown on every hit.
+//
+// Labels come from an ObjectPool and share one TTF glyph atlas whose digits are
+// rasterized once during warmup; the rise/fade is animated in update() instead of
+// per-hit actions, so a warmed layer shows numbers without allocating.
+// Add it to the same parent as the sprites being hit; while it is in the running
+// scene CombatSystem routes its damage numbers here.
+
+class DamageNumberLayer : public cocos2d::Node {
+public:
+    CREATE_FUNC(DamageNumberLayer);
+
+    // Initializes the object.
+    virtual bool init() override;
+    // Handles an event callback.
+    virtual void onEnter() override;
+    // Handles an event callback.
+    virtual void onExit() override;
+    // Updates the object state.
+    virtual void update(float dt) override;
+
+    // Shows a damage number above pos (in the parent's coordinates).
+    void show(const cocos2d::Vec2& pos, int dmg);
+
+    // Returns the layer of the running battle, or nullptr.
+    static DamageNumberLayer* current() { return s_current; }
+
+private:
+    static constexpr int WARMUP_COUNT = 48;
+    static constexpr float LIFETIME = 0.45f;
+    static constexpr float RISE_PX = 28.0f;
+    static constexpr float OFFSET_Y = 16.0f;
+    static constexpr float START_OPACITY = 230.0f;
+
+    // ActiveNumber is one number currently on screen.
+    struct ActiveNumber {
+        cocos2d::Label* label = nullptr;
+        cocos2d::Vec2 start = cocos2d::Vec2::ZERO;
+        float age = 0.0f;
+    };
+
+    // Creates one hidden label attached to this layer.
+    cocos2d::Label* createLabel();
+
+    ObjectPool<cocos2d::Label> _pool;
+    std::vector<ActiveNumber> _active;
+
+    static DamageNumberLayer* s_current;
+};
@@ -0,0 +1,132 @@
+// File: HpBarLayer.cpp
+// Brief: Implements the HpBarLayer component.
+#include "UI/HpBarLayer.h"
+
+#include <algorithm>
+
+using namespace cocos2d;
+
+HpBarLayer* HpBarLayer::s_current = nullptr;
+
+// Bar geometry in world px: background size, fill inset, and the gap below a unit's
+// feet / above a building's sprite.
+static const float kUnitBarW = 40.0f;
+static const float kBuildingBarW = 48.0f;
+static const float kBarH = 5.0f;
+static const float kBarPad = 1.0f;
+static const float kUnitGapUnder = 7.0f;
+static const float kBuildingGapOver = 12.0f;
+
+static const Color4F kBarBgColor(0.0f, 0.0f, 0.0f, 160.0f / 255.0f);
+static const Color4F kBarFillColor(60.0f / 255.0f, 220.0f / 255.0f, 90.0f / 255.0f, 220.0f / 255.0f);
+
+HpBarLayer::~HpBarLayer()
+{
+    for (auto& b : _bars) b.owner->release();
+}
+
+bool HpBarLayer::init()
+{
+    if (!Node::init()) return false;
+
+    _draw = DrawNode::create();
+    if (!_draw) return false;
+    addChild(_draw);
+
+    _bars.reserve(64);
+    _slotOf.reserve(64);
+    return true;
+}
+
+void HpBarLayer::onEnter()
+{
+    Node::onEnter();
+    s_current = this;
+    scheduleUpdate();
+}
+
+void HpBarLayer::onExit()
+{
+    if (s_current == this) s_current = nullptr;
+    unscheduleUpdate();
+    Node::onExit();
+}
+
+void HpBarLayer::setBar(Node* owner, float fraction, Style style)
+{
+    if (!owner) return;
+    fraction = std::max(0.0f, std::min(1.0f, fraction));
+
+    auto it = _slotOf.find(owner);
+    if (it == _slotOf.end())
+    {
+        owner->retain();
+        Bar b;
+        b.owner = owner;
+        _slotOf[owner] = (int)_bars.size();
+        _bars.push_back(b);
+        it = _slotOf.find(owner);
+    }
+
+    Bar& b = _bars[it->second];
+    b.fraction = fraction;
+    b.style = style;
+    b.visible = (style == Style::Unit) || fraction < 0.999f;
+}
+
+void HpBarLayer::removeBar(Node* owner)
+{
+    auto it = _slotOf.find(owner);
+    if (it == _slotOf.end()) return;
+    removeAt(it->second);
+}
+
+void HpBarLayer::removeAt(int i)
+{
+    Node* owner = _bars[i].owner;
+    _slotOf.erase(owner);
+
+    int last = (int)_bars.size() - 1;
+    if (i != last)
+    {
+        _bars[i] = _bars[last];
+        _slotOf[_bars[i].owner] = i;
+    }
+    _bars.pop_back();
+    owner->release();
+}
+
+void HpBarLayer::update(float dt)
+{
+    _draw->clear();
+
+    // Reverse order so swap-removal only moves bars that were already visited.
+    for (int i = (int)_bars.size() - 1; i >= 0; --i)
+    {
+        const Bar& b = _bars[i];
+        if (!b.owner->getParent())
+        {
+            removeAt(i);
+            continue;
+        }
+        if (!b.visible) continue;
+
+        // Placement matches the owner's anchor and scale; the bar itself stays unscaled.
+        const Node* owner = b.owner;
+        Vec2 ap = owner->getAnchorPointInPoints();
+        float dy = (b.style == Style::Unit)
+            ? -(kBarH * 0.5f + kUnitGapUnder)
+            : owner->getContentSize().height + kBuildingGapOver - ap.y;
+        Vec2 c = owner->getPosition() + Vec2(0.0f, dy * owner->getScaleY());
+
+        float w = (b.style == Style::Unit) ? kUnitBarW : kBuildingBarW;
+        Vec2 lo(c.x - w * 0.5f, c.y - kBarH * 0.5f);
+        _draw->drawSolidRect(lo, lo + Vec2(w, kBarH), kBarBgColor);
+
+        float fw = std::max(1.0f, w - kBarPad * 2.0f) * b.fraction;
+        float fh = std::max(1.0f, kBarH - kBarPad * 2.0f);
+        if (fw <= 0.0f) continue;
+        Vec2 flo(lo.x + kBarPad, c.y - fh * 0.5f);
+        _draw->drawSolidRect(flo, flo + Vec2(fw, fh), kBarFillColor);
+    }
+}
@@ -0,0 +1,61 @@
+// File: HpBarLayer.h
+// Brief: Declares the HpBarLayer component.
+#pragma once
+
+#include "cocos2d.h"
+#include <unordered_map>
+#include <vector>
+
+// HpBarLayer draws the health bar of every damaged unit and building in a battle.
+//
+// Bars live in one contiguous array and are rebuilt into a single DrawNode each
+// frame (one vertex buffer, one draw call) instead of a Node + two LayerColors per
+// sprite. Add it to the same parent as the sprites; while it is in the running
+// scene CombatSystem::ensureHpBar writes to it.
+
+class HpBarLayer : public cocos2d::Node {
+public:
+    CREATE_FUNC(HpBarLayer);
+
+    // Style picks the bar size and placement.
+    enum class Style { Unit, Building };
+
+    virtual ~HpBarLayer();
+
+    // Initializes the object.
+    virtual bool init() override;
+    // Handles an event callback.
+    virtual void onEnter() override;
+    // Handles an event callback.
+    virtual void onExit() override;
+    // Updates the object state.
+    virtual void update(float dt) override;
+
+    // Creates or updates the bar of owner. Building bars hide while at full health.
+    void setBar(cocos2d::Node* owner, float fraction, Style style);
+
+    // Drops the bar of owner, if any.
+    void removeBar(cocos2d::Node* owner);
+
+    // Returns the layer of the running battle, or nullptr.
+    static HpBarLayer* current() { return s_current; }
+
+private:
+    // Bar is one entry of the draw list. The owner is retained so a sprite removed
+    // from the scene is noticed (no parent) rather than left dangling.
+    struct Bar {
+        cocos2d::Node* owner = nullptr;
+        float fraction = 1.0f;
+        Style style = Style::Unit;
+        bool visible = true;
+    };
+
+    // Swap-removes bar i and releases its owner.
+    void removeAt(int i);
+
+    std::vector<Bar> _bars;
+    std::unordered_map<const cocos2d::Node*, int> _slotOf;
+    cocos2d::DrawNode* _draw = nullptr;
+
+    static HpBarLayer* s_current;
+};
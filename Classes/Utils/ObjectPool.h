@@ -1,2 +1,94 @@
 // File: ObjectPool.h
 // Brief: Declares the ObjectPool component.
+#pragma once
+
+#include "cocos2d.h"
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+// ObjectPool keeps a set of retained nodes of one type for reuse.
+//
+// Nodes come from the factory (which also attaches them to their parent) during
+// warmup, or lazily when the pool runs dry. Released nodes are only hidden and stay
+// in the node tree, so a warmed pool hands nodes out without allocating anything.
+// The pool holds one reference per node; the parent owns the other one.
+
+template <typename T>
+class ObjectPool {
+    static_assert(std::is_base_of<cocos2d::Node, T>::value, "ObjectPool only holds cocos2d nodes");
+
+public:
+    using Factory = std::function<T*()>;
+
+    ObjectPool() = default;
+    ~ObjectPool() { clear(); }
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    // Sets the function used to create (and attach) new nodes.
+    void setFactory(Factory factory) { _factory = std::move(factory); }
+
+    // Creates nodes until the pool holds at least count of them.
+    void warmup(int count)
+    {
+        if (count <= (int)_all.size()) return;
+        _all.reserve(count);
+        _free.reserve(count);
+        while ((int)_all.size() < count)
+        {
+            if (!create()) break;
+        }
+    }
+
+    // Returns a visible idle node, creating one if none is free (nullptr if the factory fails).
+    T* acquire()
+    {
+        if (_free.empty() && !create()) return nullptr;
+
+        T* node = _free.back();
+        _free.pop_back();
+        node->setVisible(true);
+        return node;
+    }
+
+    // Hides a node handed out by acquire() and makes it available again.
+    void release(T* node)
+    {
+        if (!node) return;
+        node->stopAllActions();
+        node->setVisible(false);
+        _free.push_back(node);
+    }
+
+    // Drops the pool's references; nodes still attached stay owned by their parent.
+    void clear()
+    {
+        for (T* node : _all) node->release();
+        _all.clear();
+        _free.clear();
+    }
+
+    int size() const { return (int)_all.size(); }
+    int available() const { return (int)_free.size(); }
+
+private:
+    bool create()
+    {
+        T* node = _factory ? _factory() : nullptr;
+        if (!node) return false;
+
+        node->retain();
+        node->setVisible(false);
+        _all.push_back(node);
+        // Keep _free able to hold every node so release() never reallocates.
+        if (_free.capacity() < _all.size()) _free.reserve(_all.capacity());
+        _free.push_back(node);
+        return true;
+    }
+
+    Factory _factory;
+    std::vector<T*> _all;
+    std::vector<T*> _free;
+};